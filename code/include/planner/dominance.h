@@ -0,0 +1,54 @@
+#ifndef PLANNER_DOMINANCE_H
+#define PLANNER_DOMINANCE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Fact sets with a cost each, answering "is some stored set of no higher cost a
+// superset of this one", as an unlimited branching tree (UBTree): every stored
+// set is a path of its facts in ascending order, and sets sharing a prefix
+// share the path. Nodes live in one array and link to their first child and
+// next sibling, in ascending fact order; every node keeps the lowest cost
+// stored below it. A superset query walks the query's facts in order,
+// descending into children below the next fact (facts the stored set has in
+// addition) and into the child equal to it; children above it and subtrees
+// whose lowest cost is too high are cut, so most of the tree is never visited.
+//
+// In a monotone search (no deletes, positive preconditions and goals only) a
+// state with a superset of the facts of another reaches everything the other
+// reaches at the same additional cost, so a state covered by one reached at no
+// higher cost need not be searched.
+class SupersetIndex
+{
+    static const uint32_t NONE = 0; // the root is never a child
+
+    struct Node
+    {
+        uint32_t fact;
+        uint32_t firstChild;
+        uint32_t nextSibling;
+        uint32_t minCost; // of the sets stored at or below the node
+        bool stored;      // a set ends at the node
+    };
+
+    std::vector<Node> nodes; // node 0 is the root
+    size_t count = 0;
+
+    bool coveredFrom(uint32_t node, const uint32_t *facts, const uint32_t *end, uint32_t cost, size_t &budget) const;
+
+public:
+    SupersetIndex();
+
+    size_t size() const { return count; }
+
+    // facts sorted ascending; storing a set again lowers its cost
+    void insert(const std::vector<uint32_t> &facts, uint32_t cost);
+
+    // True if a set of cost at most cost contains every fact of facts (sorted
+    // ascending). Superset queries can visit much of the tree, so a query gives
+    // up and answers false after visiting max_visits nodes.
+    bool containsSuperset(const std::vector<uint32_t> &facts, uint32_t cost, size_t max_visits = SIZE_MAX) const;
+};
+
+#endif
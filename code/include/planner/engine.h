@@ -0,0 +1,108 @@
+#ifndef PLANNER_ENGINE_H
+#define PLANNER_ENGINE_H
+
+#include "planner/env.h"
+#include "planner/incremental_search.h"
+#include "planner/search.h"
+#include "planner/task.h"
+
+#include <atomic>
+#include <memory>
+#include <ostream>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Embeddable planner. An engine owns one task, either grounded from a parsed
+// environment or mapped from a compiled image, and a configuration; it holds
+// no global state, so any number of engines can live in one process.
+
+struct PlannerConfig : SearchOptions
+{
+    bool lifted = false;        // search the action schemas without grounding
+    bool symmetry = false;      // prune states symmetric to one already seen
+    bool stubborn_sets = false; // partial-order reduction with strong stubborn sets
+    bool frontier = false;      // blind layered breadth-first search without a closed list
+    std::string width_search;   // "iw" or "bfws": novelty-based search instead of A*, ignoring the heuristic
+    uint32_t max_width = 2;     // largest k that "iw" tries before falling back to BFWS
+    uint32_t lookahead = 0;     // > 0: real-time search (RTAA*) expanding at most this many states per step
+    uint32_t trials = 1;        // real-time runs from the initial state, sharing what they learn
+    uint32_t max_steps = 100000; // steps of one real-time run before it gives up
+    bool invariants = false;    // prune with mutex groups and search finite-domain encoded states
+    bool validate_plans = true; // simulate every grounded plan; an invalid plan throws
+    bool optimize_plans = true; // drop redundant actions and reorder grounded plans for makespan
+
+    // Settings and statistics of every plan() call, as printed by the command
+    // line planner; nothing is written when null
+    std::ostream *log = nullptr;
+};
+
+struct PlanResult : SearchResult
+{
+    std::vector<std::string> action_names; // the plan, one name per step
+    long long time_ms = 0;
+    size_t redundant_actions = 0; // removed from the plan the search returned
+    size_t makespan = 0;          // parallel steps of the reordered plan, 0 if not optimized
+};
+
+// Loading is not thread-safe. Once a task is loaded, plan() only reads the
+// engine and keeps its search state local, so many threads may plan on one
+// engine at the same time (with log set, their statistics interleave).
+class PlannerEngine
+{
+    PlannerConfig config;
+    std::unique_ptr<Env> env;           // kept for lifted search
+    std::vector<uint64_t> image;        // task compiled in memory
+    std::unique_ptr<MappedTask> mapped; // or mapped from a file
+    TaskView view;
+    std::unordered_map<std::string, uint32_t> factIndex;
+    std::atomic<bool> cancelled;
+    std::unique_ptr<IncrementalSearch> incremental; // made by the first replan()
+
+    SearchOptions searchOptions() const;
+    PlanResult planTask(const TaskView &task, HeuristicCache *cache = nullptr) const;
+    void finishPlan(const TaskView &task, PlanResult &result) const;
+
+public:
+    explicit PlannerEngine(const PlannerConfig &config = PlannerConfig());
+
+    PlannerEngine(const PlannerEngine &) = delete;
+    PlannerEngine &operator=(const PlannerEngine &) = delete;
+
+    // Ground and compile the environment, or keep its schemas when config.lifted is set
+    void load(const Env &env);
+
+    // Map a task compiled with --compile
+    bool loadTask(const std::string &path, std::string &error);
+
+    // The grounded task; only valid after a load that grounded
+    const TaskView &task() const { return view; }
+    const PlannerConfig &settings() const { return config; }
+
+    // Plan from the loaded initial state to the loaded goal
+    PlanResult plan() const;
+
+    // Plan for another initial state and goal over the loaded (grounded) domain,
+    // both given as fact names such as "On(A,B)". A thread answering many
+    // queries passes its own cache to every call to keep the heuristic warm;
+    // it is only used when the search runs on the domain's own actions.
+    PlanResult plan(const std::set<std::string> &initial, const std::set<std::string> &goal,
+                    HeuristicCache *cache = nullptr) const;
+
+    // Plan from another initial state, given as fact names, to the loaded goal.
+    // Every call learns goal distances for the next ones (see
+    // IncrementalSearch), so when the initial state drifts a little only the
+    // changed part is searched again. Unlike plan() this updates the engine
+    // and must not run concurrently with other calls.
+    PlanResult replan(const std::set<std::string> &initial);
+
+    // Stop every running search on this engine; later searches stop at once
+    // until resetCancel(). Only touches an atomic flag, so it may be called from
+    // another thread or a signal handler.
+    void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+    void resetCancel() { cancelled.store(false, std::memory_order_relaxed); }
+    bool cancelRequested() const { return cancelled.load(std::memory_order_relaxed); }
+};
+
+#endif
@@ -0,0 +1,518 @@
+#ifndef PLANNER_ENV_H
+#define PLANNER_ENV_H
+
+#include <cstdint>
+#include <iostream>
+#include <list>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Environment description: the parsed symbols, initial and goal conditions and
+// action schemas, and the grounded actions generated from them.
+
+class GroundedCondition
+{
+    std::string predicate;
+    std::list<std::string> arg_values;
+    bool truth = true;
+
+public:
+    GroundedCondition(const std::string &predicate, const std::list<std::string> &arg_values, bool truth = true)
+    {
+        this->predicate = predicate;
+        this->truth = truth; // fixed
+        for (const std::string &l : arg_values)
+        {
+            this->arg_values.push_back(l);
+        }
+    }
+
+    GroundedCondition(const GroundedCondition &gc)
+    {
+        // Copy constructor
+        this->predicate = gc.predicate;
+        this->truth = gc.truth; // fixed
+        for (const std::string &l : gc.arg_values)
+        {
+            this->arg_values.push_back(l);
+        }
+    }
+
+    std::string get_predicate() const
+    {
+        return this->predicate;
+    }
+    std::list<std::string> get_arg_values() const
+    {
+        return this->arg_values;
+    }
+
+    bool get_truth() const
+    {
+        return this->truth;
+    }
+
+    friend std::ostream &operator<<(std::ostream &os, const GroundedCondition &pred)
+    {
+        os << pred.toString() << " ";
+        return os;
+    }
+
+    bool operator==(const GroundedCondition &rhs) const
+    {
+        if (this->predicate != rhs.predicate || this->arg_values.size() != rhs.arg_values.size())
+            return false;
+
+        auto lhs_it = this->arg_values.begin();
+        auto rhs_it = rhs.arg_values.begin();
+
+        while (lhs_it != this->arg_values.end() && rhs_it != rhs.arg_values.end())
+        {
+            if (*lhs_it != *rhs_it)
+                return false;
+            ++lhs_it;
+            ++rhs_it;
+        }
+
+        if (this->truth != rhs.get_truth()) // fixed
+            return false;
+
+        return true;
+    }
+
+    std::string toString() const
+    {
+        std::string temp;
+        temp += this->predicate;
+        temp += "(";
+        for (const std::string &l : this->arg_values)
+        {
+            temp += l + ",";
+        }
+        temp = temp.substr(0, temp.length() - 1);
+        temp += ")";
+        return temp;
+    }
+};
+
+struct GroundedConditionComparator
+{
+    bool operator()(const GroundedCondition &lhs, const GroundedCondition &rhs) const
+    {
+        return lhs == rhs;
+    }
+};
+
+struct GroundedConditionHasher
+{
+    size_t operator()(const GroundedCondition &gcond) const
+    {
+        return std::hash<std::string>{}(gcond.toString());
+    }
+};
+
+class Condition
+{
+    std::string predicate;
+    std::list<std::string> args;
+    bool truth;
+
+public:
+    Condition(const std::string &pred, const std::list<std::string> &args, const bool truth)
+    {
+        this->predicate = pred;
+        this->truth = truth;
+        for (const std::string &ar : args)
+        {
+            this->args.push_back(ar);
+        }
+    }
+
+    std::string get_predicate() const
+    {
+        return this->predicate;
+    }
+
+    std::list<std::string> get_args() const
+    {
+        return this->args;
+    }
+
+    bool get_truth() const
+    {
+        return this->truth;
+    }
+
+    friend std::ostream &operator<<(std::ostream &os, const Condition &cond)
+    {
+        os << cond.toString() << " ";
+        return os;
+    }
+
+    bool operator==(const Condition &rhs) const // fixed
+    {
+
+        if (this->predicate != rhs.predicate || this->args.size() != rhs.args.size())
+            return false;
+
+        auto lhs_it = this->args.begin();
+        auto rhs_it = rhs.args.begin();
+
+        while (lhs_it != this->args.end() && rhs_it != rhs.args.end())
+        {
+            if (*lhs_it != *rhs_it)
+                return false;
+            ++lhs_it;
+            ++rhs_it;
+        }
+
+        if (this->truth != rhs.get_truth())
+            return false;
+
+        return true;
+    }
+
+    std::string toString() const
+    {
+        std::string temp;
+        if (!this->truth)
+            temp += "!";
+        temp += this->predicate;
+        temp += "(";
+        for (const std::string &l : this->args)
+        {
+            temp += l + ",";
+        }
+        temp = temp.substr(0, temp.length() - 1);
+        temp += ")";
+        return temp;
+    }
+};
+
+struct ConditionComparator
+{
+    bool operator()(const Condition &lhs, const Condition &rhs) const
+    {
+        return lhs == rhs;
+    }
+};
+
+struct ConditionHasher
+{
+    size_t operator()(const Condition &cond) const
+    {
+        return std::hash<std::string>{}(cond.toString());
+    }
+};
+
+// Largest cost an action may have. Path costs are 32-bit with INFINITE_COST
+// reserved, so plans of up to 4000 steps at this cost still fit.
+const uint32_t MAX_ACTION_COST = 1000000;
+
+class Action
+{
+    std::string name;
+    std::list<std::string> args;
+    std::unordered_set<Condition, ConditionHasher, ConditionComparator> preconditions;
+    std::unordered_set<Condition, ConditionHasher, ConditionComparator> effects;
+    uint32_t cost;
+
+public:
+    Action(const std::string &name, const std::list<std::string> &args,
+           const std::unordered_set<Condition, ConditionHasher, ConditionComparator> &preconditions,
+           const std::unordered_set<Condition, ConditionHasher, ConditionComparator> &effects,
+           uint32_t cost = 1)
+    {
+        this->name = name;
+        this->cost = cost;
+        for (const std::string &l : args)
+        {
+            this->args.push_back(l);
+        }
+        for (const Condition &pc : preconditions)
+        {
+            this->preconditions.insert(pc);
+        }
+        for (const Condition &pc : effects)
+        {
+            this->effects.insert(pc);
+        }
+    }
+    std::string get_name() const
+    {
+        return this->name;
+    }
+    std::list<std::string> get_args() const
+    {
+        return this->args;
+    }
+    std::unordered_set<Condition, ConditionHasher, ConditionComparator> get_preconditions() const
+    {
+        return this->preconditions;
+    }
+    std::unordered_set<Condition, ConditionHasher, ConditionComparator> get_effects() const
+    {
+        return this->effects;
+    }
+    uint32_t get_cost() const
+    {
+        return this->cost;
+    }
+
+    bool operator==(const Action &rhs) const
+    {
+        if (this->get_name() != rhs.get_name() || this->get_args().size() != rhs.get_args().size())
+            return false;
+
+        return true;
+    }
+
+    friend std::ostream &operator<<(std::ostream &os, const Action &ac)
+    {
+        os << ac.toString() << std::endl;
+        os << "Precondition: ";
+        for (const Condition &precond : ac.get_preconditions())
+            os << precond;
+        os << std::endl;
+        os << "Effect: ";
+        for (const Condition &effect : ac.get_effects())
+            os << effect;
+        os << std::endl;
+        return os;
+    }
+
+    std::string toString() const
+    {
+        std::string temp;
+        temp += this->get_name();
+        temp += "(";
+        for (const std::string &l : this->get_args())
+        {
+            temp += l + ",";
+        }
+        temp = temp.substr(0, temp.length() - 1);
+        temp += ")";
+        return temp;
+    }
+};
+
+struct ActionComparator
+{
+    bool operator()(const Action &lhs, const Action &rhs) const
+    {
+        return lhs == rhs;
+    }
+};
+
+struct ActionHasher
+{
+    size_t operator()(const Action &ac) const
+    {
+        return std::hash<std::string>{}(ac.get_name());
+    }
+};
+
+class Env
+{
+    std::unordered_set<GroundedCondition, GroundedConditionHasher, GroundedConditionComparator> initial_conditions;
+    std::unordered_set<GroundedCondition, GroundedConditionHasher, GroundedConditionComparator> goal_conditions;
+    std::unordered_set<Action, ActionHasher, ActionComparator> actions;
+    std::unordered_set<std::string> symbols;
+
+public:
+    void remove_initial_condition(const GroundedCondition &gc)
+    {
+        this->initial_conditions.erase(gc);
+    }
+    void add_initial_condition(const GroundedCondition &gc)
+    {
+        this->initial_conditions.insert(gc);
+    }
+    void add_goal_condition(const GroundedCondition &gc)
+    {
+        this->goal_conditions.insert(gc);
+    }
+    void remove_goal_condition(const GroundedCondition &gc)
+    {
+        this->goal_conditions.erase(gc);
+    }
+    void add_symbol(const std::string &symbol)
+    {
+        symbols.insert(symbol);
+    }
+    void add_symbols(const std::list<std::string> &symbols)
+    {
+        for (const std::string &l : symbols)
+            this->symbols.insert(l);
+    }
+    void add_action(const Action &action)
+    {
+        this->actions.insert(action);
+    }
+
+    Action get_action(const std::string &name) const
+    {
+        for (Action a : this->actions)
+        {
+            if (a.get_name() == name)
+                return a;
+        }
+        throw std::runtime_error("Action " + name + " not found!");
+    }
+
+    std::unordered_set<std::string> get_symbols() const
+    {
+        return this->symbols;
+    }
+
+    friend std::ostream &operator<<(std::ostream &os, const Env &w)
+    {
+        os << "***** Environment *****" << std::endl
+           << std::endl;
+        os << "Symbols: ";
+        for (const std::string &s : w.get_symbols())
+            os << s + ",";
+        os << std::endl;
+        os << "Initial conditions: ";
+        for (const GroundedCondition &s : w.initial_conditions)
+            os << s;
+        os << std::endl;
+        os << "Goal conditions: ";
+        for (const GroundedCondition &g : w.goal_conditions)
+            os << g;
+        os << std::endl;
+        os << "Actions:" << std::endl;
+        for (const Action &g : w.actions)
+            os << g << std::endl;
+        std::cout << "***** Environment Created! *****" << std::endl;
+        return os;
+    }
+
+    // add getters
+    auto get_initial_conditions() const
+    {
+        return this->initial_conditions;
+    }
+    auto get_goal_conditions() const
+    {
+        return this->goal_conditions;
+    }
+    auto get_actions() const
+    {
+        return this->actions;
+    }
+};
+
+class GroundedAction
+{
+    std::string name;
+    std::list<std::string> arg_values;
+    std::unordered_set<GroundedCondition, GroundedConditionHasher, GroundedConditionComparator> grounded_preconditions;
+    std::unordered_set<GroundedCondition, GroundedConditionHasher, GroundedConditionComparator> grounded_effects;
+    uint32_t cost = 1;
+
+public:
+    GroundedAction(const std::string &name, const std::list<std::string> &arg_values)
+    {
+        this->name = name;
+        for (const std::string &ar : arg_values)
+        {
+            this->arg_values.push_back(ar);
+        }
+    }
+
+    // New constructor that accepts grounded preconditions and effects
+    GroundedAction(const std::string &name, const std::list<std::string> &arg_values,
+                   const std::unordered_set<GroundedCondition, GroundedConditionHasher, GroundedConditionComparator> &preconds,
+                   const std::unordered_set<GroundedCondition, GroundedConditionHasher, GroundedConditionComparator> &effects,
+                   uint32_t cost = 1)
+    {
+        this->name = name;
+        this->cost = cost;
+        for (const std::string &ar : arg_values)
+        {
+            this->arg_values.push_back(ar);
+        }
+        for (const auto &pc : preconds)
+            this->grounded_preconditions.insert(pc);
+        for (const auto &ef : effects)
+            this->grounded_effects.insert(ef);
+    }
+
+    // Accessors for grounded preconditions/effects
+    auto get_grounded_preconditions() const {
+        return this->grounded_preconditions;
+    }
+
+    auto get_grounded_effects() const {
+        return this->grounded_effects;
+    }
+
+    uint32_t get_cost() const
+    {
+        return this->cost;
+    }
+
+    std::string get_name() const
+    {
+        return this->name;
+    }
+
+    std::list<std::string> get_arg_values() const
+    {
+        return this->arg_values;
+    }
+
+    bool operator==(const GroundedAction &rhs) const
+    {
+        if (this->name != rhs.name || this->arg_values.size() != rhs.arg_values.size())
+            return false;
+
+        auto lhs_it = this->arg_values.begin();
+        auto rhs_it = rhs.arg_values.begin();
+
+        while (lhs_it != this->arg_values.end() && rhs_it != rhs.arg_values.end())
+        {
+            if (*lhs_it != *rhs_it)
+                return false;
+            ++lhs_it;
+            ++rhs_it;
+        }
+        return true;
+    }
+
+    friend std::ostream &operator<<(std::ostream &os, const GroundedAction &gac)
+    {
+        os << gac.toString() << " ";
+        return os;
+    }
+
+    std::string toString() const
+    {
+        std::string temp;
+        temp += this->name;
+        temp += "(";
+        for (const std::string &l : this->arg_values)
+        {
+            temp += l + ",";
+        }
+        temp = temp.substr(0, temp.length() - 1);
+        temp += ")";
+        return temp;
+    }
+};
+
+std::list<std::string> parse_symbols(std::string symbols_str);
+
+// Parse an environment file
+Env *create_env(char *filename);
+
+std::vector<GroundedAction> generateAllGroundedActions(const Env &env);
+
+// Collect the facts of a condition list; "!" entries remove a fact, as in create_env
+std::set<std::string> parseConditionList(const std::string &conditions);
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef PLANNER_FRONTIER_SEARCH_H
+#define PLANNER_FRONTIER_SEARCH_H
+
+#include "planner/search.h"
+#include "planner/task.h"
+
+#include <cstddef>
+
+// Blind breadth-first search in layers, without a closed list. Every action
+// must cost one (tasks with Cost lines are rejected), so layer d holds the
+// states at distance d. A layer is a sorted array of packed states;
+// duplicates within the new layer are removed by sorting and against earlier
+// layers by a merge, as in frontier search. When every action can be undone
+// by another one, comparing with the two previous layers is enough and memory
+// follows the widest layers instead of every state seen. Otherwise an old
+// state can come back, so all earlier layers are kept as one more sorted
+// array to merge against; memory is then that of a compact closed list, and
+// the search still ends on finite tasks.
+//
+// Since no parents are kept, the plan is rebuilt after the goal is found by
+// searching again to ever smaller depths and stepping back one predecessor at
+// a time.
+
+struct FrontierSearchResult : SearchResult
+{
+    size_t peak_layer_states = 0;
+    size_t peak_layer_bytes = 0;
+    bool reversible = true; // two layers were enough to remove duplicates
+};
+
+FrontierSearchResult frontierSearch(const TaskView &task, const SearchOptions &options);
+
+#endif
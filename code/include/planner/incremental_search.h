@@ -0,0 +1,62 @@
+#ifndef PLANNER_INCREMENTAL_SEARCH_H
+#define PLANNER_INCREMENTAL_SEARCH_H
+
+#include "planner/search.h"
+#include "planner/task.h"
+
+#include <cstdint>
+#include <unordered_map>
+
+// Replanning towards a fixed goal from initial states that drift between
+// calls: Tree Adaptive A* (Hernandez, Sun, Koenig and Meseguer), the variant
+// of LPA* / D* Lite for a moving start and fixed actions and goal. Goal
+// distances do not depend on the start, so everything a search learns about
+// them stays valid:
+//   - after a plan of cost C, every expanded state s gets h(s) = C - g(s) if
+//     that is higher, which stays admissible and consistent;
+//   - the states on every plan found have exact distances and a next action,
+//     and form a tree towards the goal.
+// A later search stops as soon as it pops a state of that tree, whose f is
+// then the exact cost of the plan through it; since it has the lowest f on
+// the open list, that plan is optimal. When the start moved only a few steps
+// the search joins the tree after a handful of expansions and only that part
+// is searched again. Values are exact with admissible, consistent heuristics
+// (edl, ham, hmax); with hadd the plans are as good as A* with hadd.
+struct IncrementalResult : SearchResult
+{
+    bool joined = false;      // the plan ends along a plan found before
+    size_t known_states = 0;  // states with a stored h-value
+    size_t solved_states = 0; // states with an exact distance and next action
+};
+
+class IncrementalSearch
+{
+    typedef SearchNode<PackedState> Node;
+
+    struct StateValue
+    {
+        uint32_t h;          // heuristic, learned lower bound or exact distance
+        bool exact = false;  // on a plan: h is the goal distance
+        int32_t next = -1;   // first action of that plan, -1 at a goal
+    };
+
+    const TaskView &task;
+    SearchOptions options;
+    GroundedSpace space;
+    TieBreaking tieBreaking;
+    std::unordered_map<PackedState, StateValue, PackedStateHasher> values;
+    size_t solvedStates = 0;
+
+    StateValue &value(const PackedState &state);
+
+public:
+    IncrementalSearch(const TaskView &task, const SearchOptions &options);
+
+    IncrementalSearch(const IncrementalSearch &) = delete;
+    IncrementalSearch &operator=(const IncrementalSearch &) = delete;
+
+    // Plan from start to the task's goal, reusing every earlier call
+    IncrementalResult plan(const PackedState &start);
+};
+
+#endif
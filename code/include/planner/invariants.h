@@ -0,0 +1,76 @@
+#ifndef PLANNER_INVARIANTS_H
+#define PLANNER_INVARIANTS_H
+
+#include "planner/search.h"
+#include "planner/stubborn_sets.h"
+#include "planner/task.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Mutex groups: sets of facts of which at most one holds in every reachable
+// state. Candidates come from the predicates of the task's facts. For one
+// predicate and argument position, the facts that agree on that argument form
+// a group, such as At(R,*); two predicates may also be joined on the shared
+// argument, such as Clear(A) with On(*,A). A group is kept if it is an
+// inductive invariant: at most one of its facts holds initially, and every
+// action adding one of them either needs one of them and deletes it, or needs
+// two of them and so never applies. Actions that relaxed exploration from the
+// initial state never reaches, or with a negative precondition on a static true
+// fact, are ignored, since they never apply either.
+
+struct MutexGroup
+{
+    std::string name; // the pattern, such as "Clear(A) On(*,A)"
+    std::vector<uint32_t> facts;
+};
+
+struct InvariantAnalysis
+{
+    std::vector<MutexGroup> groups;     // maximal groups of two or more changing facts
+    std::vector<bool> reachable_action; // false if unreachable in the relaxation or two preconditions are mutex
+    uint32_t pruned_actions = 0;
+    bool goal_unreachable = false; // the goal needs two mutex facts or a fact it cannot have
+};
+
+InvariantAnalysis analyzeInvariants(const TaskView &task);
+
+// Finite-domain (SAS+) encoding of the states of a task. Every chosen mutex
+// group becomes one variable whose value is the fact that holds, or none; the
+// remaining changing facts are binary variables. Static facts are not stored
+// and come back from the initial state when decoding. Groups are chosen
+// largest first and each fact belongs to one variable.
+class FiniteDomainEncoding
+{
+    struct Variable
+    {
+        std::vector<uint32_t> facts; // value v > 0 is facts[v - 1]
+        uint32_t offset;             // first bit; a variable never spans two words
+        uint32_t bits;
+    };
+
+    std::vector<Variable> variables;
+    std::vector<int32_t> factVariable; // -1 for static facts
+    std::vector<uint32_t> factValue;
+    PackedState staticFacts;
+    uint32_t numWords = 1;
+    uint32_t numBits = 0;
+
+public:
+    FiniteDomainEncoding(const TaskView &task, const std::vector<MutexGroup> &groups);
+
+    uint32_t words() const { return numWords; }
+    uint32_t bits() const { return numBits; }
+    size_t num_variables() const { return variables.size(); }
+
+    // States are expected to satisfy the mutex groups, as reachable states do
+    void encode(const PackedState &state, PackedState &packed) const;
+    void decode(const PackedState &packed, PackedState &state) const;
+};
+
+// A* over encoded states; the closed list and every node store the short encoding
+SearchResult compactAstar(const TaskView &task, const FiniteDomainEncoding &encoding, const SearchOptions &options,
+                          StubbornSets *stubbornSets = nullptr);
+
+#endif
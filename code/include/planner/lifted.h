@@ -0,0 +1,27 @@
+#ifndef PLANNER_LIFTED_H
+#define PLANNER_LIFTED_H
+
+#include "planner/env.h"
+#include "planner/search.h"
+
+#include <string>
+#include <vector>
+
+// Lifted successor generation works on the action schemas of the Env instead of
+// the grounded task. A state is the sorted list of ids of its true facts; facts
+// are interned on first use, so memory grows with the states that are actually
+// visited rather than with |symbols|^arity. The applicable groundings of a
+// schema are found per state by joining its positive preconditions against the
+// state's facts, indexed by predicate and by (predicate, argument position, symbol).
+
+struct LiftedSearchResult : SearchResult
+{
+    std::vector<std::string> action_names; // the plan, as grounded action names
+    size_t facts_interned = 0;
+    size_t groundings_interned = 0;
+};
+
+// A* over the action schemas without grounding the task up front
+LiftedSearchResult liftedSearch(const Env &env, const SearchOptions &options);
+
+#endif
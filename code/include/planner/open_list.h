@@ -0,0 +1,153 @@
+#ifndef PLANNER_OPEN_LIST_H
+#define PLANNER_OPEN_LIST_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+// Order among open nodes of equal f
+enum TieBreaking
+{
+    TIE_LOWEST_H,      // "h": lowest h, newest first; with f = g + h also the highest g
+    TIE_LOWEST_H_FIFO, // "h-fifo": lowest h, oldest first
+    TIE_LIFO,          // "lifo": newest first, h ignored
+    TIE_FIFO,          // "fifo": oldest first, h ignored
+    TIE_RANDOM         // "random": uniformly at random, seeded
+};
+
+inline bool parseTieBreaking(const std::string &name, TieBreaking &policy)
+{
+    static const char *const names[] = {"h", "h-fifo", "lifo", "fifo", "random"};
+    for (int i = 0; i < 5; i++) {
+        if (name == names[i]) {
+            policy = (TieBreaking)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Open list over integer f and h values. Nodes sit in buckets by f and, within
+// an f bucket, by h (or all in one h bucket when the policy ignores h); a pop
+// takes the lowest f, then the lowest h, and then picks within the bucket by
+// the policy, so ties are exact and need no comparisons. Only nonempty buckets
+// exist, in maps ordered by value, so memory follows the number of distinct
+// values on the list rather than their size and any cost below INFINITE_COST
+// works. The lowest bucket is kept as a cursor; pushes at its f and h, the
+// common case in A*, and every pop then skip the map lookups.
+template <typename Node>
+class BucketOpenList
+{
+    // Nodes before head have been popped from the front
+    struct Bucket
+    {
+        std::vector<Node *> nodes;
+        size_t head = 0;
+
+        bool empty() const { return head == nodes.size(); }
+    };
+
+    struct Layer
+    {
+        std::map<uint32_t, Bucket> byH;
+        size_t size = 0;
+    };
+
+    std::map<uint32_t, Layer> layers;
+    Bucket *lowest = nullptr; // cursor on the lowest bucket, nullptr when unknown
+    uint32_t lowestF = 0, lowestH = 0;
+    size_t count = 0;
+    TieBreaking policy;
+    std::mt19937 random;
+
+    uint32_t key(const Node *node) const { return policy == TIE_LOWEST_H || policy == TIE_LOWEST_H_FIFO ? node->h : 0; }
+
+    // The lowest bucket; the list is not empty
+    Bucket &settle()
+    {
+        if (!lowest) {
+            auto layer = layers.begin();
+            auto bucket = layer->second.byH.begin();
+            lowest = &bucket->second;
+            lowestF = layer->first;
+            lowestH = bucket->first;
+        }
+        return *lowest;
+    }
+
+public:
+    explicit BucketOpenList(TieBreaking policy = TIE_LOWEST_H, uint32_t seed = 1) : policy(policy), random(seed) {}
+
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+
+    void push(Node *node)
+    {
+        uint32_t h = key(node);
+        if (lowest && node->f == lowestF && h == lowestH) {
+            lowest->nodes.push_back(node);
+            layers.begin()->second.size++;
+        } else {
+            Layer &layer = layers[node->f];
+            layer.byH[h].nodes.push_back(node);
+            layer.size++;
+            if (lowest && (node->f < lowestF || (node->f == lowestF && h < lowestH)))
+                lowest = nullptr;
+        }
+        count++;
+    }
+
+    // The next node to pop; with TIE_RANDOM the choice is made here and kept for pop()
+    Node *top()
+    {
+        Bucket &bucket = settle();
+        if (policy == TIE_FIFO || policy == TIE_LOWEST_H_FIFO)
+            return bucket.nodes[bucket.head];
+        if (policy == TIE_RANDOM) {
+            size_t pick = bucket.head + random() % (bucket.nodes.size() - bucket.head);
+            std::swap(bucket.nodes[pick], bucket.nodes.back());
+        }
+        return bucket.nodes.back();
+    }
+
+    void pop()
+    {
+        Bucket &bucket = settle();
+        if (policy == TIE_FIFO || policy == TIE_LOWEST_H_FIFO)
+            bucket.head++;
+        else
+            bucket.nodes.pop_back();
+        count--;
+
+        // Drop emptied buckets so that the maps hold only values still open
+        if (bucket.empty()) {
+            auto layer = layers.begin();
+            layer->second.byH.erase(layer->second.byH.begin());
+            if (--layer->second.size == 0)
+                layers.erase(layer);
+            lowest = nullptr;
+        } else {
+            layers.begin()->second.size--;
+        }
+    }
+
+    // Empty the list
+    void clear()
+    {
+        layers.clear();
+        lowest = nullptr;
+        count = 0;
+    }
+
+    // Lowest f on the list
+    uint32_t min_f()
+    {
+        settle();
+        return lowestF;
+    }
+};
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef PLANNER_PLAN_H
+#define PLANNER_PLAN_H
+
+#include "planner/task.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Plan validation and post-processing on the grounded task. Every pass is one
+// or two sweeps over the plan touching each action's masks once, so they are
+// cheap enough to run on every plan.
+
+// Simulate the plan from the initial state; checks every precondition and the
+// goal, and says which step failed
+bool validatePlan(const TaskView &task, const std::vector<uint32_t> &plan, std::string &error);
+
+// Drop redundant actions: subsequences that lead back to a state visited
+// before, and actions that backward justification finds unused (nothing they
+// add is needed later as a precondition or goal, nothing they delete is needed
+// false). The plan must be valid; returns the number of actions removed.
+size_t removeRedundantActions(const TaskView &task, std::vector<uint32_t> &plan);
+
+// Deorder the plan and put every action in the earliest layer after the
+// actions it depends on or interferes with; actions are then sorted by layer,
+// which keeps the plan valid. Returns the number of layers (the makespan).
+size_t reorderForMakespan(const TaskView &task, std::vector<uint32_t> &plan);
+
+#endif
@@ -0,0 +1,173 @@
+#ifndef PLANNER_PROFILING_H
+#define PLANNER_PROFILING_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Scoped timers, counters and histograms for the hot paths. They compile to
+// nothing unless PLANNER_PROFILING is defined (cmake -DPLANNER_PROFILING=ON).
+// Each call site registers itself once, by name, and then only does relaxed
+// atomic adds, so the layer is usable from the batch worker threads. A JSON
+// summary is written at exit; --trace additionally records every timed scope as
+// a Chrome trace event (chrome://tracing, Perfetto).
+
+#ifdef PLANNER_PROFILING
+
+struct ProfileSite
+{
+    enum Kind
+    {
+        TIMER,
+        COUNTER,
+        HISTOGRAM
+    };
+
+    // Histogram buckets: one per value below EXACT_BUCKETS, then one per power of two
+    static const int EXACT_BUCKETS = 256;
+    static const int NUM_BUCKETS = EXACT_BUCKETS + 48;
+
+    std::string name;
+    Kind kind;
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> total_ns{0};
+    std::atomic<int64_t> sum_milli{0};
+    std::atomic<uint64_t> buckets[NUM_BUCKETS];
+
+    ProfileSite(const std::string &name, Kind kind) : name(name), kind(kind)
+    {
+        for (auto &b : buckets)
+            b.store(0);
+    }
+
+    static int bucketOf(uint64_t value)
+    {
+        if (value < EXACT_BUCKETS)
+            return value;
+        int log = 63 - __builtin_clzll(value);
+        return std::min(NUM_BUCKETS - 1, EXACT_BUCKETS + log - 8);
+    }
+
+    static uint64_t bucketLowerBound(int bucket)
+    {
+        return bucket < EXACT_BUCKETS ? bucket : uint64_t(1) << (bucket - EXACT_BUCKETS + 8);
+    }
+
+    void record(double value)
+    {
+        count.fetch_add(1, std::memory_order_relaxed);
+        sum_milli.fetch_add((int64_t)(value * 1000), std::memory_order_relaxed);
+        buckets[bucketOf(value < 0 ? 0 : (uint64_t)value)].fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+struct TraceEvent
+{
+    const ProfileSite *site;
+    uint64_t start_ns;
+    uint64_t duration_ns;
+};
+
+class Profiler
+{
+    std::mutex lock;
+    std::map<std::string, std::unique_ptr<ProfileSite>> sites;
+    std::vector<std::pair<uint32_t, std::shared_ptr<std::vector<TraceEvent>>>> traceBuffers;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+public:
+    bool tracing = false;
+    std::string trace_path;
+    std::string summary_path; // stderr when empty
+
+    static Profiler &instance()
+    {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    ProfileSite &site(const std::string &name, ProfileSite::Kind kind)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        std::unique_ptr<ProfileSite> &site = sites[name];
+        if (!site)
+            site.reset(new ProfileSite(name, kind));
+        return *site;
+    }
+
+    uint64_t now_ns() const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    std::vector<TraceEvent> &threadTrace()
+    {
+        thread_local std::shared_ptr<std::vector<TraceEvent>> buffer;
+        if (!buffer) {
+            buffer = std::make_shared<std::vector<TraceEvent>>();
+            std::lock_guard<std::mutex> guard(lock);
+            traceBuffers.push_back(std::make_pair((uint32_t)traceBuffers.size() + 1, buffer));
+        }
+        return *buffer;
+    }
+
+    // JSON summary to summary_path (stderr when empty), plus the trace when tracing
+    void writeSummary();
+};
+
+class ScopedProfileTimer
+{
+    ProfileSite &site;
+    uint64_t start;
+
+public:
+    explicit ScopedProfileTimer(ProfileSite &site) : site(site), start(Profiler::instance().now_ns()) {}
+
+    ~ScopedProfileTimer()
+    {
+        Profiler &profiler = Profiler::instance();
+        uint64_t duration = profiler.now_ns() - start;
+        site.count.fetch_add(1, std::memory_order_relaxed);
+        site.total_ns.fetch_add(duration, std::memory_order_relaxed);
+        if (profiler.tracing)
+            profiler.threadTrace().push_back(TraceEvent{&site, start, duration});
+    }
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name)                                                                                       \
+    static ProfileSite &PROFILE_CONCAT(profile_site_, __LINE__) = Profiler::instance().site(name, ProfileSite::TIMER); \
+    ScopedProfileTimer PROFILE_CONCAT(profile_timer_, __LINE__)(PROFILE_CONCAT(profile_site_, __LINE__))
+#define PROFILE_COUNT(name, n)                                                                   \
+    do {                                                                                         \
+        static ProfileSite &profile_site = Profiler::instance().site(name, ProfileSite::COUNTER); \
+        profile_site.count.fetch_add(n, std::memory_order_relaxed);                              \
+    } while (0)
+#define PROFILE_HISTOGRAM(name, value)                                                             \
+    do {                                                                                           \
+        static ProfileSite &profile_site = Profiler::instance().site(name, ProfileSite::HISTOGRAM); \
+        profile_site.record(value);                                                                \
+    } while (0)
+
+#else
+
+#define PROFILE_SCOPE(name) \
+    do {                    \
+    } while (0)
+#define PROFILE_COUNT(name, n) \
+    do {                       \
+    } while (0)
+#define PROFILE_HISTOGRAM(name, value) \
+    do {                               \
+    } while (0)
+
+#endif
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef PLANNER_REALTIME_SEARCH_H
+#define PLANNER_REALTIME_SEARCH_H
+
+#include "planner/search.h"
+#include "planner/task.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Real-time search (RTAA*, Koenig and Likhachev) for controllers that must act
+// before a full plan exists. Every step runs A* from the current state for at
+// most lookahead expansions, then raises the h-value of every expanded state
+// s to f* - g(s), where f* is the f of the best open node, and returns the
+// first action towards that node. The h-values live in a table that persists
+// for the lifetime of the object, so repeated runs over the same task and goal
+// learn from each other; with an admissible heuristic the values stay
+// admissible and repeated trials converge to an optimal plan.
+class RealTimeSearch
+{
+    typedef SearchNode<PackedState> Node;
+
+    const TaskView &task;
+    SearchOptions options;
+    GroundedSpace space;
+    uint32_t lookahead;
+    TieBreaking tieBreaking;
+    std::unordered_map<PackedState, uint32_t, PackedStateHasher> hTable; // heuristic or learned value of every state seen
+
+    uint32_t lookup(const PackedState &state);
+
+public:
+    uint64_t states_expanded = 0;
+    uint64_t states_generated = 0;
+
+    RealTimeSearch(const TaskView &task, const SearchOptions &options, uint32_t lookahead);
+
+    RealTimeSearch(const RealTimeSearch &) = delete;
+    RealTimeSearch &operator=(const RealTimeSearch &) = delete;
+
+    // Choose the next action from state. False at a goal, or if no goal is
+    // reachable from state; the state is then recorded as a dead end.
+    bool step(const PackedState &state, uint32_t &action);
+
+    // Current h-value of a state, computing the heuristic if it was never seen
+    uint32_t h(const PackedState &state) { return lookup(state); }
+    size_t learned_states() const { return hTable.size(); }
+};
+
+struct RealTimeResult : SearchResult
+{
+    std::vector<uint64_t> trial_costs; // executed cost of every trial, loops included
+    size_t learned_states = 0;
+};
+
+// Run trials from the initial state, each executing steps until the goal or
+// max_steps, which ends the run with SEARCH_STEP_LIMIT; the h-table is shared
+// by all trials and the plan is that of the last one
+RealTimeResult realTimeSearch(const TaskView &task, const SearchOptions &options, uint32_t lookahead, uint32_t trials,
+                              uint32_t max_steps);
+
+#endif
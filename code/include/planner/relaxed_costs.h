@@ -0,0 +1,66 @@
+#ifndef PLANNER_RELAXED_COSTS_H
+#define PLANNER_RELAXED_COSTS_H
+
+#include "planner/task.h"
+
+#include <cstdint>
+#include <vector>
+
+enum RelaxedAggregation
+{
+    RELAXED_ADD, // h_add: an action costs its own cost plus the sum of its precondition costs
+    RELAXED_MAX  // h_max: its own cost plus the most expensive precondition; admissible
+};
+
+// h_add and h_max over the delete relaxation. Every fact has a cost of reaching
+// it from the state, and h is the sum or maximum of the goal fact costs.
+//
+// The fact costs of the last evaluated state are kept, and the next state is
+// evaluated by updating them with the facts that differ. Added facts drop to
+// zero and the decrease is propagated; facts whose best achiever depended on a
+// removed fact are reset and rebuilt from their other achievers. The work per
+// evaluation scales with the facts whose cost changes, which for a successor
+// evaluated after its parent or a sibling is usually a small part of the task.
+// One instance per search: evaluation updates the kept costs.
+class RelaxedCostHeuristic
+{
+    TaskView task; // a copy, so that retarget() can swap in another instance
+    RelaxedAggregation aggregation;
+
+    // Action -> positive preconditions and add effects; fact -> actions with the
+    // fact as positive precondition, actions adding the fact
+    std::vector<std::vector<uint32_t>> preconditions, addEffects, preconditionOf, achievers;
+
+    // Costs of the last evaluated state; supporter is the achiever giving the
+    // cost, -1 for facts of the state and unreachable facts
+    PackedState current;
+    bool valid = false;
+    std::vector<uint32_t> cost;
+    std::vector<int32_t> supporter;
+
+    // Scratch state
+    std::vector<std::pair<uint32_t, uint32_t>> heap;
+    std::vector<uint32_t> affected;
+    std::vector<bool> isAffected;
+    std::vector<uint32_t> pendingPreconditions;
+
+    uint32_t actionCost(uint32_t a) const;
+    void push(uint32_t f, uint32_t c, int32_t achiever);
+    void propagate();
+    void recompute(const PackedState &state);
+    void update(const PackedState &state);
+    uint32_t goalCost() const;
+
+public:
+    RelaxedCostHeuristic(const TaskView &task, RelaxedAggregation aggregation);
+
+    // Relaxed cost of the goal, INFINITE_COST if the relaxed task is unsolvable
+    uint32_t evaluate(const PackedState &state);
+
+    // Evaluate the goal of another instance of the same domain (same actions,
+    // see TaskInstance). Fact costs do not depend on the goal, so the indexes
+    // and the kept costs carry over.
+    void retarget(const TaskView &instance) { task = instance; }
+};
+
+#endif
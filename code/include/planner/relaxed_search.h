@@ -0,0 +1,84 @@
+#ifndef PLANNER_RELAXED_SEARCH_H
+#define PLANNER_RELAXED_SEARCH_H
+
+#include "planner/open_list.h"
+#include "planner/relaxed_costs.h"
+#include "planner/task.h"
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+// The edl heuristic on a grounded task: the cost of an optimal plan that
+// ignores delete effects and negative preconditions (h+), with the same values
+// as relaxedPlanLength, which stays as the reference (--verify-edl). Instead
+// of uniform-cost search it runs A* guided by h_max, which is consistent in the
+// relaxed task, so the first goal popped is still optimal:
+//   - only actions that can contribute to the goal are applied (those adding
+//     a goal fact or a precondition of such an action, computed once), and
+//     never one that adds nothing new;
+//   - h_max of a successor is updated from the previous evaluation, which for
+//     a relaxed successor only lowers fact costs;
+//   - states live in one flat arena with an open-addressing id table, and the
+//     arena, table, entries and open list are reused by every call, so a
+//     warmed-up evaluation allocates nothing but its memo entry;
+//   - results are remembered per projection of the state onto the facts that
+//     matter to the goal, since states that agree there have the same h+.
+// Like relaxedPlanLength it returns 0 when the relaxed goal is unreachable
+// and when cancel is set.
+class OptimalRelaxedSearch
+{
+    struct Entry
+    {
+        uint32_t g;
+        uint32_t h;
+        uint32_t f;
+        uint32_t id;
+        bool closed;
+    };
+
+    TaskView task; // a copy, so that retarget() can swap in another instance
+    const uint32_t words;
+    std::vector<std::vector<uint32_t>> achievers; // fact -> actions adding it
+    std::vector<uint32_t> goalFacts;              // of the current relevance analysis
+    std::vector<bool> relevantAction;
+    PackedState relevantFacts; // mask of goal facts and preconditions of relevant actions
+    RelaxedCostHeuristic hmax;
+    std::unordered_map<PackedState, uint32_t, PackedStateHasher> memo;
+
+    // Per call, reused: states by id in the arena, slots of the id table valid
+    // when their stamp is the current call's
+    std::vector<uint64_t> arena;
+    std::vector<uint32_t> slots;
+    std::vector<uint32_t> stamps;
+    uint32_t stamp = 0;
+    size_t used = 0; // states of this call; entries beyond are left from earlier calls
+    std::deque<Entry> entries;
+    BucketOpenList<Entry> openList;
+    std::vector<uint32_t> applicable;
+    PackedState key, state, neighbor;
+
+    const uint64_t *stateWords(uint32_t id) const { return arena.data() + (size_t)id * words; }
+    uint32_t intern(const uint64_t *s, bool &added);
+    void grow();
+    void findRelevant();
+
+public:
+    uint64_t memo_hits = 0;
+
+    explicit OptimalRelaxedSearch(const TaskView &task);
+
+    OptimalRelaxedSearch(const OptimalRelaxedSearch &) = delete;
+    OptimalRelaxedSearch &operator=(const OptimalRelaxedSearch &) = delete;
+
+    uint32_t evaluate(const PackedState &start, const std::atomic<bool> *cancel = nullptr);
+
+    // Evaluate the goal of another instance of the same domain (same actions,
+    // see TaskInstance). The arena, tables and h_max costs carry over; the
+    // relevant actions and the memo are redone unless the goal is the same.
+    void retarget(const TaskView &instance);
+};
+
+#endif
@@ -0,0 +1,704 @@
+#ifndef PLANNER_SEARCH_H
+#define PLANNER_SEARCH_H
+
+#include "planner/dominance.h"
+#include "planner/open_list.h"
+#include "planner/profiling.h"
+#include "planner/relaxed_costs.h"
+#include "planner/relaxed_search.h"
+#include "planner/stubborn_sets.h"
+#include "planner/task.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum SearchStatus
+{
+    SEARCH_SOLVED,
+    SEARCH_UNSOLVABLE,
+    SEARCH_TIMEOUT,
+    SEARCH_EXPANSION_LIMIT,
+    SEARCH_STEP_LIMIT, // a real-time run took max_steps steps without reaching the goal
+    SEARCH_OUT_OF_MEMORY,
+    SEARCH_CANCELLED
+};
+
+const char *searchStatusName(SearchStatus status);
+
+// Zero means unlimited
+struct SearchLimits
+{
+    double time_limit_ms = 0;
+    uint64_t max_expansions = 0;
+    double memory_limit_mb = 0;
+};
+
+// Everything a search reads besides its space; passed by reference, never global
+struct SearchOptions
+{
+    bool enable_heuristics = true;
+    std::string heuristic_fn = "edl"; // "edl", "ham", or on grounded tasks "hadd" and "hmax"
+    SearchLimits limits;
+
+    // Order of A* among open nodes of equal f: "h", "h-fifo", "lifo", "fifo" or
+    // "random" (see TieBreaking); the seed only matters for "random"
+    std::string tie_breaking = "h";
+    uint32_t tie_breaking_seed = 1;
+
+    // Move a closed state back to the open list when a cheaper path to it is
+    // found. Only needed for inconsistent heuristics (h_add, weighted or
+    // maximized estimates); with consistent ones it never triggers.
+    bool reopen_closed = false;
+
+    // Skip states of the relaxed (edl) search whose facts are covered by an
+    // expanded state; grounded tasks use OptimalRelaxedSearch, so this applies
+    // to lifted ones and to the reference values of verify_edl
+    bool relaxed_dominance = true;
+
+    // Check every grounded edl value against relaxedPlanLength, throwing on a
+    // difference. Slow; for testing the fast evaluator
+    bool verify_edl = false;
+
+    // Keep a parent link (8 bytes) per state in A*; without them the plan is
+    // rebuilt from the g-values after the search, for one more pass over the
+    // states reached
+    bool keep_parents = true;
+
+    // Progress lines on stderr: "text", "json" or "off", at most once per interval
+    std::string progress_format = "off";
+    int progress_interval_ms = 500;
+
+    // Cooperative cancellation; the search stops at its next check once set
+    const std::atomic<bool> *cancel = nullptr;
+};
+
+double residentMegabytes();
+
+// Rate-limited progress lines for long searches. tick() is called once per
+// expansion but only reads the clock every 2^k calls, with k adapted so that
+// clock reads happen a few times per interval; a line is written to stderr at
+// most once per interval. With format "json" every line is a JSON object for
+// log collectors.
+class ProgressReporter
+{
+    typedef std::chrono::steady_clock Clock;
+
+    std::string format;
+    int interval_ms;
+    Clock::time_point start;
+    Clock::time_point lastCheck;
+    Clock::time_point lastReport;
+    uint64_t calls = 0;
+    uint64_t checkMask = 0;
+    uint64_t lastExpanded = 0;
+    uint64_t lastGenerated = 0;
+    float bestH = std::numeric_limits<float>::infinity();
+
+    // Adapts the clock-check mask and writes a line if the interval has passed
+    void check(Clock::time_point now, uint64_t expanded, uint64_t generated, size_t open, size_t closed, float f);
+
+public:
+    ProgressReporter(const std::string &format, int interval_ms);
+
+    void tick(uint64_t expanded, uint64_t generated, size_t open, size_t closed, float f, float h)
+    {
+        bestH = std::min(bestH, h);
+        if ((++calls & checkMask) != 0)
+            return;
+        check(Clock::now(), expanded, generated, open, closed, f);
+    }
+};
+
+// Checks a search against its limits. The cancellation flag is read on every
+// call; the clock only every 16 and resident memory only every 256 calls.
+class SearchGuard
+{
+    const SearchLimits &limits;
+    const std::atomic<bool> *cancel;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    uint64_t calls = 0;
+
+public:
+    explicit SearchGuard(const SearchOptions &options) : limits(options.limits), cancel(options.cancel) {}
+
+    // True if the search must stop; status says why
+    bool exceeded(uint64_t expansions, SearchStatus &status)
+    {
+        calls++;
+        if (cancel && cancel->load(std::memory_order_relaxed)) {
+            status = SEARCH_CANCELLED;
+            return true;
+        }
+        if (limits.max_expansions > 0 && expansions >= limits.max_expansions) {
+            status = SEARCH_EXPANSION_LIMIT;
+            return true;
+        }
+        if (limits.time_limit_ms > 0 && (calls & 15) == 0 &&
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() > limits.time_limit_ms) {
+            status = SEARCH_TIMEOUT;
+            return true;
+        }
+        if (limits.memory_limit_mb > 0 && (calls & 255) == 0 && residentMegabytes() > limits.memory_limit_mb) {
+            status = SEARCH_OUT_OF_MEMORY;
+            return true;
+        }
+        return false;
+    }
+};
+
+struct SearchResult
+{
+    SearchStatus status = SEARCH_UNSOLVABLE;
+    std::vector<uint32_t> plan; // action ids of the search space
+    uint64_t cost = 0;          // sum of the action costs of the plan
+    float f_bound = 0;          // proven lower bound on the optimal plan cost (admissible heuristics)
+    int states_expanded = 0;
+    int states_generated = 0;
+    int states_reopened = 0;
+
+    bool solved() const { return status == SEARCH_SOLVED; }
+};
+
+// The searches below are written against a search space, so that the grounded
+// task and the lifted schemas share one A* and one relaxed search. A space provides
+//   State, StateHasher
+//   State initial_state()
+//   bool is_goal(const State &)
+//   bool is_goal_relaxed(const State &)                                 ignoring negative goals
+//   void applicable_actions(const State &, vector<uint32_t> &)          action ids
+//   void applicable_actions_relaxed(const State &, vector<uint32_t> &)  ignoring negative preconditions
+//   void apply(const State &, uint32_t action, State &)
+//   void apply_relaxed(const State &, uint32_t action, State &)         add effects only
+//   void state_facts(const State &, vector<uint32_t> &)                 true fact ids, ascending
+//   uint32_t action_cost(uint32_t action)
+//   uint32_t goal_count_heuristic(const State &)
+//   uint32_t heuristic(const State &)                                   INFINITE_COST for dead ends
+//   string action_name(uint32_t action)
+// Costs and heuristic values are integers, so the open lists bucket nodes by value.
+
+template <typename StateT>
+struct SearchNode
+{
+    StateT state;
+    uint32_t g;
+    uint32_t h;
+    uint32_t f;
+    SearchNode *parent;
+    int32_t action; // id of the action that produced this node, -1 at the root
+};
+
+// What a search knows about one state. g is INFINITE_COST until a path is
+// found; node is the open or expanded node with that g, so its parent chain is
+// the best path, and null for a dead end.
+template <typename Node>
+struct StateRecord
+{
+    uint32_t g = INFINITE_COST;
+    bool closed = false;
+    Node *node = nullptr;
+};
+
+const uint32_t NO_STATE = UINT32_MAX;
+
+// What A* keeps per state: the state itself is stored once, as the key of the
+// search's id table, and the entry only holds its values
+struct StateEntry
+{
+    uint32_t g = INFINITE_COST;
+    uint32_t h = 0; // INFINITE_COST for a dead end
+    uint32_t f = 0;
+    uint32_t id = 0;
+    bool closed = false;
+};
+
+// Best predecessor of a state: the parent's id and the action id, 8 bytes
+struct ParentLink
+{
+    uint32_t parent; // NO_STATE at the start
+    uint32_t action;
+};
+
+// Unsatisfied goal facts divided by the largest effect size, rounded up: the
+// least number of actions still needed, each costing at least the cheapest action
+uint32_t getHeuristicHam(const TaskView &task, const PackedState &state);
+
+// Cost of an optimal plan that ignores delete effects and negative preconditions,
+// or 0 (still admissible) if cancel is set while it runs. The relaxed task is
+// monotone, so with dominance a successor whose facts are covered by a state
+// already reached with no higher g is pruned; the covering state stays on the
+// open list or has been expanded, so the cost is unchanged. Every state holds
+// the facts of the start state, so only the facts added since are indexed.
+// A query visits a bounded number of index nodes, and since indexing costs
+// about as much as the expansions it saves, the search stops using it once a
+// window of 256 queries prunes fewer than one in 8.
+template <typename Space>
+uint32_t relaxedPlanLength(Space &space, const typename Space::State &state, const std::atomic<bool> *cancel = nullptr,
+                           bool dominance = true)
+{
+    typedef typename Space::State State;
+    typedef SearchNode<State> Node;
+
+    PROFILE_SCOPE("edl_search");
+    PROFILE_COUNT("edl_searches", 1);
+
+    // Variable to store distance
+    uint32_t h_val = 0;
+
+    // Open list (buckets by g; successors carry no h)
+    BucketOpenList<Node> openList;
+
+    // Best g, closed flag and node of every state seen
+    std::unordered_map<State, StateRecord<Node>, typename Space::StateHasher> records;
+
+    // Every node is owned here; the open list only holds pointers
+    std::vector<std::unique_ptr<Node>> nodes;
+
+    // Added facts and g of the states reached
+    SupersetIndex reached;
+    std::vector<uint32_t> startFacts, facts, added;
+    size_t dominanceQueries = 0, dominated = 0;
+
+    // Initialize the open list with the start state
+    nodes.emplace_back(new Node{state, 0, space.goal_count_heuristic(state), 0, nullptr, -1});
+    Node *startState = nodes.back().get();
+    startState->f = startState->g + startState->h;
+    openList.push(startState);
+    StateRecord<Node> &startRecord = records[startState->state];
+    startRecord.g = startState->g;
+    startRecord.node = startState;
+    if (dominance) {
+        space.state_facts(state, startFacts);
+        reached.insert(added, 0);
+    }
+
+    std::vector<uint32_t> applicableActions;
+    State neighbor;
+
+    while (!openList.empty()) {
+        // Give up on cancellation; 0 is still an admissible estimate
+        if (cancel && cancel->load(std::memory_order_relaxed)) {
+            return 0;
+        }
+
+        // Get the state with the lowest f value
+        Node *currentState = openList.top();
+        openList.pop();
+
+        // Skip nodes superseded by a cheaper path to their state
+        StateRecord<Node> &current = records[currentState->state];
+        if (current.node != currentState) {
+            continue;
+        }
+        current.closed = true;
+
+        PROFILE_COUNT("edl_expansions", 1);
+
+        // Check if we reached the goal: all goal conditions must be present in the current state
+        if (space.is_goal_relaxed(currentState->state)) {
+            h_val = currentState->g;
+            break;
+        }
+
+        // Add neighbors to open list
+        space.applicable_actions_relaxed(currentState->state, applicableActions);
+
+        for (uint32_t action : applicableActions) {
+            // Apply effects: add positive effects ONLY (empty-delete-list ignores negative effects)
+            space.apply_relaxed(currentState->state, action, neighbor);
+
+            // If this path to neighbor is better than any previous, or unseen, push to open list;
+            // the relaxed search has no heuristic, so closed states are final
+            uint32_t new_g = currentState->g + space.action_cost(action);
+            StateRecord<Node> &record = records[neighbor];
+            if (record.closed || new_g >= record.g) {
+                continue;
+            }
+            if (dominance) {
+                space.state_facts(neighbor, facts);
+                added.clear();
+                std::set_difference(facts.begin(), facts.end(), startFacts.begin(), startFacts.end(),
+                                    std::back_inserter(added));
+                bool covered = reached.containsSuperset(added, new_g, 64 * (added.size() + 1));
+                dominated += covered;
+                if (++dominanceQueries == 256) {
+                    dominance = dominated * 8 >= dominanceQueries;
+                    dominanceQueries = dominated = 0;
+                }
+                if (covered) {
+                    PROFILE_COUNT("edl_dominated", 1);
+                    continue;
+                }
+                reached.insert(added, new_g);
+            }
+            record.g = new_g;
+            nodes.emplace_back(new Node{neighbor, new_g, 0, new_g, currentState, (int32_t)action});
+            record.node = nodes.back().get();
+            openList.push(record.node);
+        }
+    }
+
+    return h_val;
+}
+
+// Dispatch on the selected heuristic function
+template <typename Space>
+uint32_t getHeuristic(Space &space, const typename Space::State &state, const SearchOptions &options)
+{
+    uint32_t h_val = 0;
+
+    if (!options.enable_heuristics) {
+        return 0;
+    }
+
+    if (options.heuristic_fn == "ham") {
+        h_val = space.goal_count_heuristic(state);
+        return h_val;
+    }
+
+    if (options.heuristic_fn == "edl") {
+        h_val = relaxedPlanLength(space, state, options.cancel, options.relaxed_dominance);
+        return h_val;
+    }
+
+    return 0;
+}
+
+// Heuristic objects kept across the searches of one thread over one domain,
+// such as a batch worker's queries: the first search builds them and the
+// others retarget them to their own instance, so the per-action indexes are
+// built once and the kept costs stay warm. Only for one configuration.
+struct HeuristicCache
+{
+    std::unique_ptr<RelaxedCostHeuristic> relaxed_costs;
+    std::unique_ptr<OptimalRelaxedSearch> relaxed_search;
+};
+
+// Search space over a compiled task; action ids are task action indices
+struct GroundedSpace
+{
+    typedef PackedState State;
+    typedef PackedStateHasher StateHasher;
+
+    const TaskView &task;
+    const SearchOptions &options;
+    StubbornSets *stubborn_sets = nullptr; // optional partial-order reduction
+    RelaxedCostHeuristic *relaxed_costs = nullptr; // for hadd and hmax
+    OptimalRelaxedSearch *relaxed_search = nullptr; // for edl
+    HeuristicCache owned;                           // unless the caller keeps them
+
+    // cache, if given, is the caller's and must be used with the same options
+    GroundedSpace(const TaskView &task, const SearchOptions &options, HeuristicCache *cache = nullptr)
+        : task(task), options(options)
+    {
+        HeuristicCache &heuristics = cache ? *cache : owned;
+        if (options.enable_heuristics && (options.heuristic_fn == "hadd" || options.heuristic_fn == "hmax")) {
+            if (heuristics.relaxed_costs)
+                heuristics.relaxed_costs->retarget(task);
+            else
+                heuristics.relaxed_costs.reset(
+                    new RelaxedCostHeuristic(task, options.heuristic_fn == "hadd" ? RELAXED_ADD : RELAXED_MAX));
+            relaxed_costs = heuristics.relaxed_costs.get();
+        }
+        if (options.enable_heuristics && options.heuristic_fn == "edl") {
+            if (heuristics.relaxed_search)
+                heuristics.relaxed_search->retarget(task);
+            else
+                heuristics.relaxed_search.reset(new OptimalRelaxedSearch(task));
+            relaxed_search = heuristics.relaxed_search.get();
+        }
+    }
+
+    State initial_state() const { return task.initial_state(); }
+    bool is_goal(const State &state) const { return isGoal(task, state); }
+    bool is_goal_relaxed(const State &state) const { return isGoalEDL(task, state); }
+    void applicable_actions(const State &state, std::vector<uint32_t> &actions) const
+    {
+        getApplicableActions(task, state, actions);
+        if (stubborn_sets)
+            stubborn_sets->prune(state, actions);
+    }
+    void applicable_actions_relaxed(const State &state, std::vector<uint32_t> &actions) const { getApplicableActionsEDL(task, state, actions); }
+    void apply(const State &state, uint32_t action, State &result) const { applyAction(task, state, action, result); }
+    void apply_relaxed(const State &state, uint32_t action, State &result) const { applyActionEDL(task, state, action, result); }
+    void state_facts(const State &state, std::vector<uint32_t> &facts) const
+    {
+        facts.clear();
+        for (uint32_t w = 0; w < task.state_words(); w++) {
+            for (uint64_t bits = state[w]; bits; bits &= bits - 1)
+                facts.push_back(w * 64 + __builtin_ctzll(bits));
+        }
+    }
+    uint32_t action_cost(uint32_t action) const { return task.action_cost(action); }
+    uint32_t goal_count_heuristic(const State &state) const { return getHeuristicHam(task, state); }
+    std::string action_name(uint32_t action) const { return task.action_name(action); }
+
+    uint32_t heuristic(const State &state)
+    {
+        if (relaxed_costs)
+            return relaxed_costs->evaluate(state);
+        if (relaxed_search) {
+            uint32_t h = relaxed_search->evaluate(state, options.cancel);
+            if (options.verify_edl) {
+                uint32_t expected = relaxedPlanLength(*this, state, options.cancel, options.relaxed_dominance);
+                bool cancelled = options.cancel && options.cancel->load(std::memory_order_relaxed);
+                if (h != expected && !cancelled)
+                    throw std::runtime_error("edl mismatch: " + std::to_string(h) + " instead of " +
+                                             std::to_string(expected));
+            }
+            return h;
+        }
+        return getHeuristic(*this, state, options);
+    }
+};
+
+// Plan to the state goal of an A* run that kept no parent links: from each
+// state s step back to a reached state p with an action a such that
+// apply(p, a) = s and g(p) + cost(a) <= g(s), trying states in order of
+// decreasing g. Every g is the cost of a path found to its state, so the
+// steps end at the start (id 0); with a consistent heuristic each step keeps
+// g exact and the plan costs g(goal). False if no predecessor is found, which
+// only zero-cost cycles can cause.
+template <typename Space>
+bool regressPlan(Space &space, const std::vector<const typename Space::State *> &states,
+                 const std::deque<StateEntry> &entries, uint32_t goal, std::vector<uint32_t> &plan)
+{
+    PROFILE_SCOPE("regress_plan");
+    std::vector<uint32_t> byG;
+    for (uint32_t id = 0; id < entries.size(); id++) {
+        if (entries[id].g != INFINITE_COST)
+            byG.push_back(id);
+    }
+    std::stable_sort(byG.begin(), byG.end(), [&](uint32_t x, uint32_t y) { return entries[x].g < entries[y].g; });
+
+    std::vector<bool> onPath(entries.size(), false);
+    std::vector<uint32_t> applicable;
+    typename Space::State successor;
+    plan.clear();
+    for (uint32_t current = goal; current != 0;) {
+        onPath[current] = true;
+        const uint32_t g = entries[current].g;
+        auto end = std::upper_bound(byG.begin(), byG.end(), g, [&](uint32_t value, uint32_t id) { return value < entries[id].g; });
+        uint32_t previous = NO_STATE, step = 0;
+        for (auto it = end; it != byG.begin() && previous == NO_STATE;) {
+            uint32_t candidate = *--it;
+            if (onPath[candidate])
+                continue;
+            space.applicable_actions(*states[candidate], applicable);
+            for (uint32_t a : applicable) {
+                if (entries[candidate].g + space.action_cost(a) > g)
+                    continue;
+                space.apply(*states[candidate], a, successor);
+                if (successor == *states[current]) {
+                    previous = candidate;
+                    step = a;
+                    break;
+                }
+            }
+        }
+        if (previous == NO_STATE)
+            return false;
+        plan.push_back(step);
+        current = previous;
+    }
+    std::reverse(plan.begin(), plan.end());
+    return true;
+}
+
+// A* over a search space. Reports progress only if options ask for it, so it can run on worker threads.
+// Stops early when a limit is hit or cancellation is requested; the result then
+// carries the reason and the lowest f on the open list as the proven bound.
+//
+// Every state is stored once, as the key of the id table; its values sit in an
+// entry addressed by a 32-bit id, which the open list points at, and its best
+// predecessor in an 8-byte link of parent id and action id. Closed entries are
+// final and a g improvement pushes the entry again at its lower f, so an entry
+// popped when already closed is a leftover and skipped. Without
+// options.keep_parents the links are not kept at all and the plan is rebuilt
+// by regressPlan.
+template <typename Space>
+SearchResult astarSearch(Space &space, const SearchOptions &options)
+{
+    typedef typename Space::State State;
+
+    SearchResult result;
+
+    // Open list (buckets by f, then h)
+    TieBreaking tieBreaking;
+    if (!parseTieBreaking(options.tie_breaking, tieBreaking))
+        throw std::runtime_error("Unknown tie-breaking policy " + options.tie_breaking);
+    BucketOpenList<StateEntry> openList(tieBreaking, options.tie_breaking_seed);
+
+    // Id of every state seen: one lookup per generated state. Entries live in a
+    // deque, so the open list's pointers survive its growth; states[id] points
+    // at the key in ids, which never moves either.
+    std::unordered_map<State, uint32_t, typename Space::StateHasher> ids;
+    std::vector<const State *> states;
+    std::deque<StateEntry> entries;
+    std::vector<ParentLink> parents;
+    size_t closedStates = 0;
+
+    auto reach = [&](const State &state, bool &added) -> uint32_t {
+        auto inserted = ids.emplace(state, (uint32_t)entries.size());
+        added = inserted.second;
+        if (added) {
+            states.push_back(&inserted.first->first);
+            entries.emplace_back();
+            if (options.keep_parents)
+                parents.push_back(ParentLink{NO_STATE, 0});
+        }
+        return inserted.first->second;
+    };
+
+    // Initialize the open list with the start state
+    bool added;
+    uint32_t startId = reach(space.initial_state(), added);
+    StateEntry &start = entries[startId];
+    start.id = startId;
+    start.g = 0;
+    start.h = space.heuristic(*states[startId]);
+    start.f = start.h;
+    if (start.h != INFINITE_COST)
+        openList.push(&start);
+
+    std::vector<uint32_t> applicableActions;
+    State neighbor;
+
+    std::unique_ptr<ProgressReporter> progress;
+    if (options.progress_format != "off")
+        progress.reset(new ProgressReporter(options.progress_format, options.progress_interval_ms));
+
+    SearchGuard guard(options);
+
+    while (!openList.empty()) {
+
+        if (guard.exceeded(result.states_expanded, result.status)) {
+            result.f_bound = openList.min_f();
+            return result;
+        }
+
+        // Get the state with the lowest f value
+        StateEntry *current;
+        {
+            PROFILE_SCOPE("open_pop");
+            current = openList.top();
+            openList.pop();
+        }
+
+        {
+            PROFILE_SCOPE("duplicate_check");
+
+            // Lazy deletion: a closed entry was pushed again at a lower f and expanded there
+            if (current->closed) {
+                PROFILE_COUNT("stale_pops", 1);
+                continue;
+            }
+            current->closed = true;
+            closedStates++;
+        }
+        const uint32_t currentId = current->id;
+
+        // Increment states expanded counter
+        result.states_expanded++;
+        PROFILE_COUNT("expansions", 1);
+        PROFILE_HISTOGRAM("h_value", current->h);
+        if (progress)
+            progress->tick(result.states_expanded, result.states_generated, openList.size(), closedStates,
+                           current->f, current->h);
+
+        // Check if we reached the goal: all goal conditions must be present in the current state
+        if (space.is_goal(*states[currentId])) {
+            if (!options.keep_parents) {
+                if (!regressPlan(space, states, entries, currentId, result.plan))
+                    throw std::runtime_error("Unable to rebuild the plan from the g-values");
+            } else {
+                for (uint32_t id = currentId; parents[id].parent != NO_STATE; id = parents[id].parent)
+                    result.plan.push_back(parents[id].action);
+                std::reverse(result.plan.begin(), result.plan.end());
+            }
+            result.status = SEARCH_SOLVED;
+            result.cost = current->g;
+            result.f_bound = current->g;
+            break;
+        }
+
+        // Add neighbors to open list
+        space.applicable_actions(*states[currentId], applicableActions);
+        PROFILE_HISTOGRAM("branching_factor", applicableActions.size());
+
+        for (uint32_t action : applicableActions) {
+            // Generate new state by applying the action's effects
+            {
+                PROFILE_SCOPE("successor");
+                space.apply(*states[currentId], action, neighbor);
+            }
+            result.states_generated++;
+            PROFILE_COUNT("generated", 1);
+
+            // Consistent heuristics never find a cheaper path to a closed
+            // state, so the fast path skips closed states outright
+            uint32_t new_g = current->g + space.action_cost(action);
+            uint32_t id;
+            {
+                PROFILE_SCOPE("duplicate_check");
+                // Ids are 32 bits
+                if (entries.size() == NO_STATE) {
+                    result.status = SEARCH_OUT_OF_MEMORY;
+                    result.f_bound = current->f;
+                    return result;
+                }
+                id = reach(neighbor, added);
+            }
+            StateEntry &entry = entries[id];
+            if (added) {
+                // h depends on the state only, so it is evaluated once
+                PROFILE_SCOPE("heuristic");
+                entry.id = id;
+                entry.h = space.heuristic(*states[id]);
+                if (entry.h == INFINITE_COST)
+                    PROFILE_COUNT("dead_ends", 1);
+            }
+
+            // No relaxed plan, so no plan: a dead end
+            if (entry.h == INFINITE_COST)
+                continue;
+            if (entry.closed && !options.reopen_closed)
+                continue;
+
+            // Only a better path to the neighbor, or an unseen one, is pushed to the open list
+            if (new_g >= entry.g)
+                continue;
+            if (entry.closed) {
+                entry.closed = false;
+                closedStates--;
+                result.states_reopened++;
+                PROFILE_COUNT("reopened", 1);
+            } else if (entry.g != INFINITE_COST) {
+                PROFILE_COUNT("open_g_improvements", 1);
+            }
+            entry.g = new_g;
+            entry.f = new_g + entry.h;
+            if (options.keep_parents)
+                parents[id] = ParentLink{currentId, action};
+            PROFILE_SCOPE("open_push");
+            openList.push(&entry);
+        }
+    }
+
+    if (result.status == SEARCH_UNSOLVABLE)
+        result.f_bound = std::numeric_limits<float>::infinity();
+    return result;
+}
+
+SearchResult astar(const TaskView &task, const SearchOptions &options, HeuristicCache *cache = nullptr);
+
+#endif
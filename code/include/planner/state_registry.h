@@ -0,0 +1,96 @@
+#ifndef PLANNER_STATE_REGISTRY_H
+#define PLANNER_STATE_REGISTRY_H
+
+#include "planner/task.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Packed states shared by many threads, each mapped to a 32-bit id, for
+// searches that generate states in parallel. A single map behind one lock
+// serializes every thread on that lock and its cache line; here the states
+// are split by hash into shards, each an open-addressing table with its own
+// lock, so threads inserting different states rarely meet:
+//   - a slot holds the address of its state, its id and 32 bits of its hash,
+//     so a probe only reads a state when those bits match;
+//   - a new state is copied into the arena of the thread inserting it, which
+//     only that thread writes; with the default first-touch policy its pages
+//     are on that thread's NUMA node;
+//   - a Writer inserts a batch of states, such as the successors of one
+//     expansion, taking the lock of each shard once for all of them.
+// An id is the shard in the low bits and the index within the shard above.
+// Any number of threads may insert and look up at the same time, each
+// inserting through its own Writer.
+class StateRegistry
+{
+    struct Slot
+    {
+        const uint64_t *state; // nullptr when free
+        uint32_t id;
+        uint32_t tag; // low 32 bits of the hash, also the slot position
+    };
+
+    struct Shard
+    {
+        std::mutex lock;
+        std::vector<Slot> slots;
+        std::vector<const uint64_t *> states; // by index within the shard
+        char padding[64];                     // keeps neighbouring shards off each other's cache lines
+    };
+
+    // Blocks of states written by one thread
+    struct Arena
+    {
+        std::vector<std::unique_ptr<uint64_t[]>> blocks;
+        size_t used = 0; // words of the last block
+    };
+
+    const uint32_t words;
+    const uint32_t shardBits;
+    std::unique_ptr<Shard[]> shards;
+    std::mutex arenasLock;
+    std::vector<std::unique_ptr<Arena>> arenas;
+
+    uint64_t hash(const uint64_t *state) const;
+    uint32_t shardOf(uint64_t hash) const { return shardBits ? (uint32_t)(hash >> (64 - shardBits)) : 0; }
+    const Slot *findLocked(const Shard &shard, const uint64_t *state, uint32_t tag) const;
+    uint32_t insertLocked(uint32_t s, const uint64_t *state, uint32_t tag, Arena &arena, bool &added);
+    const uint64_t *store(Arena &arena, const uint64_t *state);
+
+public:
+    // Inserts for one thread; not thread-safe itself
+    class Writer
+    {
+        StateRegistry &registry;
+        Arena &arena;
+        std::vector<std::vector<uint32_t>> pending; // positions of the batch in each shard
+        std::vector<uint64_t> hashes;
+
+        friend class StateRegistry;
+        Writer(StateRegistry &registry, Arena &arena);
+
+    public:
+        // Id of the state, added if new
+        uint32_t insert(const PackedState &state, bool &added);
+
+        // Ids of a batch of states in order, and which of them were new
+        void insert(const std::vector<PackedState> &states, std::vector<uint32_t> &ids, std::vector<bool> &added);
+    };
+
+    // shards is rounded up to a power of two
+    StateRegistry(uint32_t words, uint32_t shards = 64);
+
+    StateRegistry(const StateRegistry &) = delete;
+    StateRegistry &operator=(const StateRegistry &) = delete;
+
+    // One per inserting thread; lives as long as the registry
+    Writer writer();
+
+    bool find(const PackedState &state, uint32_t &id);
+    PackedState state(uint32_t id);
+    size_t size();
+};
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef PLANNER_STUBBORN_SETS_H
+#define PLANNER_STUBBORN_SETS_H
+
+#include "planner/task.h"
+
+#include <cstdint>
+#include <vector>
+
+// Strong stubborn sets. In a non-goal state the set starts with the achievers of
+// one unsatisfied goal fact and is closed under two rules: for an applicable
+// action add every action it interferes with, for an inapplicable action add the
+// achievers of one of its unsatisfied preconditions. Only applicable actions in
+// the set are expanded, which keeps A* complete and optimal. One instance per
+// search: pruning keeps scratch state.
+class StubbornSets
+{
+    const TaskView &task;
+
+    // Fact -> actions with the fact as positive/negative precondition, add/delete effect
+    std::vector<std::vector<uint32_t>> preposUsers, prenegUsers, adders, deleters;
+
+    // Interference lists are computed on first use
+    std::vector<std::vector<uint32_t>> interference;
+    std::vector<bool> interferenceKnown;
+
+    // Scratch state for one pruning call
+    std::vector<uint32_t> inSet;
+    uint32_t epoch = 0;
+    std::vector<uint32_t> stubborn;
+
+    void addAll(const std::vector<uint32_t> &actions);
+
+    template <typename Visit>
+    void forEachFact(const uint64_t *mask, Visit visit) const
+    {
+        for (uint32_t w = 0; w < task.state_words(); w++) {
+            uint64_t bits = mask[w];
+            while (bits) {
+                visit(w * 64 + __builtin_ctzll(bits));
+                bits &= bits - 1;
+            }
+        }
+    }
+
+    // Actions b that a disables, that disable a, or whose effects conflict with a's
+    const std::vector<uint32_t> &interferingWith(uint32_t a);
+
+    // Achievers of the unsatisfied precondition of a with the fewest achievers
+    const std::vector<uint32_t> &necessaryEnablingSet(const PackedState &state, uint32_t a) const;
+
+public:
+    long long applicable_total = 0;
+    long long applicable_pruned = 0;
+
+    explicit StubbornSets(const TaskView &task);
+
+    // Restrict the applicable actions of a non-goal state to a strong stubborn set
+    void prune(const PackedState &state, std::vector<uint32_t> &applicable);
+};
+
+#endif
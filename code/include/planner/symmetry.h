@@ -0,0 +1,48 @@
+#ifndef PLANNER_SYMMETRY_H
+#define PLANNER_SYMMETRY_H
+
+#include "planner/search.h"
+#include "planner/task.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// Object symmetries of a grounded task. Candidate pairs of interchangeable
+// objects come from colour refinement of the problem description graph (object
+// vertices, initial and goal atom vertices, edges labelled with the argument
+// position). A candidate transposition of two objects is kept only if it maps
+// the fact table, every action (preconditions and effects), the initial state
+// and the goal onto themselves, so every generator is a true automorphism.
+//
+// Only transpositions of single objects are tried, so the group is a product
+// of full symmetric groups on object orbits. Symmetries that must move several
+// objects at once (swapping two rows of a grid, or two block-and-place pairs)
+// are not found, and tasks with only those get no reduction.
+
+struct SymmetryGroup
+{
+    // Each generator is an object transposition; on facts it is an involution
+    // stored as the list of fact pairs it swaps
+    std::vector<std::vector<std::pair<uint32_t, uint32_t>>> generators;
+    std::vector<std::vector<uint32_t>> action_images; // per generator, the image of every action
+    std::vector<std::vector<std::string>> object_orbits; // orbits with more than one object
+};
+
+// Split "Pred(a,b)" into its predicate and arguments
+void parseAtomName(const std::string &name, std::string &predicate, std::vector<std::string> &args);
+
+SymmetryGroup detectSymmetries(const TaskView &task);
+
+// Greedy representative: apply generators while they make the state
+// lexicographically smaller. This is a local minimum, not the orbit minimum, so
+// one orbit can have several representatives and symmetric states may still be
+// searched more than once; pruning is partial but never wrong. The indices of
+// the generators applied, in order, are appended to applied if given.
+void canonicalize(const SymmetryGroup &group, PackedState &state, std::vector<uint32_t> *applied = nullptr);
+
+// A* over representatives; the plan is unfolded onto the real initial state by
+// following the automorphism between each representative and the real state
+SearchResult symmetricAstar(const TaskView &task, const SymmetryGroup &group, const SearchOptions &options);
+
+#endif
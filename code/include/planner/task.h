@@ -0,0 +1,253 @@
+#ifndef PLANNER_TASK_H
+#define PLANNER_TASK_H
+
+#include "planner/env.h"
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// A grounded task is stored as one flat, versioned image so that it can be
+// written to disk by --compile and mapped back in with no parsing. Facts and
+// grounded actions are identified by dense indices; states are bitsets of
+// state_words 64-bit words. Every section starts on an 8-byte boundary.
+
+#define TASK_MAGIC "PLNTASK"
+#define TASK_FORMAT_VERSION 3
+
+enum ActionMask
+{
+    MASK_PRE_POS = 0,
+    MASK_PRE_NEG = 1,
+    MASK_ADD = 2,
+    MASK_DEL = 3,
+    NUM_ACTION_MASKS = 4
+};
+
+struct TaskHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t num_facts;
+    uint32_t num_actions;
+    uint32_t state_words;
+    uint32_t max_effect_size;
+    uint32_t num_goals;
+    uint32_t min_action_cost;     // 1 when there are no actions
+    uint32_t max_action_cost;
+    uint64_t fact_names_offset;   // uint32_t[num_facts + 1], offsets into strings
+    uint64_t action_names_offset; // uint32_t[num_actions + 1], offsets into strings
+    uint64_t strings_offset;      // char[]
+    uint64_t masks_offset;        // uint64_t[num_actions][NUM_ACTION_MASKS][state_words]
+    uint64_t costs_offset;        // uint32_t[num_actions]
+    uint64_t initial_offset;      // uint64_t[state_words]
+    uint64_t goal_offset;         // uint32_t[num_goals], ids of the facts that must hold
+    uint64_t goal_masks_offset;   // uint64_t[2][state_words], facts that must hold, then facts that must not
+    uint64_t successor_offset;    // uint32_t[num_facts + 2] bucket starts, then uint32_t[num_actions]
+    uint64_t file_size;
+};
+
+typedef std::vector<uint64_t> PackedState;
+
+// Heuristic value of a state from which no plan reaches the goal
+const uint32_t INFINITE_COST = UINT32_MAX;
+
+// Read-only view over a task image, either in memory or mapped from a file
+struct TaskView
+{
+    const TaskHeader *header = nullptr;
+    const uint32_t *fact_name_offsets = nullptr;
+    const uint32_t *action_name_offsets = nullptr;
+    const char *strings = nullptr;
+    const uint64_t *masks = nullptr;
+    const uint32_t *costs = nullptr;
+    const uint64_t *initial = nullptr;
+    const uint32_t *goal = nullptr;
+    const uint64_t *goal_pos = nullptr;
+    const uint64_t *goal_neg = nullptr;
+    const uint32_t *successor_starts = nullptr;
+    const uint32_t *successor_actions = nullptr;
+
+    uint32_t num_facts() const { return header->num_facts; }
+    uint32_t num_actions() const { return header->num_actions; }
+    uint32_t state_words() const { return header->state_words; }
+
+    std::string fact_name(uint32_t f) const
+    {
+        return std::string(strings + fact_name_offsets[f], fact_name_offsets[f + 1] - fact_name_offsets[f]);
+    }
+
+    std::string action_name(uint32_t a) const
+    {
+        return std::string(strings + action_name_offsets[a], action_name_offsets[a + 1] - action_name_offsets[a]);
+    }
+
+    const uint64_t *mask(uint32_t a, ActionMask kind) const
+    {
+        return masks + ((size_t)a * NUM_ACTION_MASKS + kind) * header->state_words;
+    }
+
+    uint32_t action_cost(uint32_t a) const { return costs[a]; }
+
+    // Every action costs 1, as in tasks without Cost lines
+    bool unit_costs() const { return header->min_action_cost == 1 && header->max_action_cost == 1; }
+
+    // Successor generator index: bucket f holds the actions keyed on fact f,
+    // bucket num_facts holds the actions that have to be checked in every state.
+    const uint32_t *bucket_begin(uint32_t b) const { return successor_actions + successor_starts[b]; }
+    const uint32_t *bucket_end(uint32_t b) const { return successor_actions + successor_starts[b + 1]; }
+
+    PackedState initial_state() const
+    {
+        return PackedState(initial, initial + header->state_words);
+    }
+};
+
+struct PackedStateHasher
+{
+    size_t operator()(const PackedState &state) const
+    {
+        size_t seed = 0;
+        for (uint64_t word : state) {
+            seed ^= std::hash<uint64_t>{}(word) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        }
+        return seed;
+    }
+};
+
+inline bool testFact(const PackedState &state, uint32_t f)
+{
+    return (state[f / 64] >> (f % 64)) & 1;
+}
+
+inline bool isApplicable(const TaskView &task, const PackedState &state, uint32_t a)
+{
+    const uint64_t *pos = task.mask(a, MASK_PRE_POS);
+    const uint64_t *neg = task.mask(a, MASK_PRE_NEG);
+    for (uint32_t w = 0; w < task.state_words(); w++) {
+        if ((state[w] & pos[w]) != pos[w] || (state[w] & neg[w]) != 0)
+            return false;
+    }
+    return true;
+}
+
+inline bool isApplicableEDL(const TaskView &task, const PackedState &state, uint32_t a)
+{
+    const uint64_t *pos = task.mask(a, MASK_PRE_POS);
+    for (uint32_t w = 0; w < task.state_words(); w++) {
+        if ((state[w] & pos[w]) != pos[w])
+            return false;
+    }
+    return true;
+}
+
+// Apply an action's effects: deletes first, then adds
+inline void applyAction(const TaskView &task, const PackedState &state, uint32_t a, PackedState &result)
+{
+    const uint64_t *add = task.mask(a, MASK_ADD);
+    const uint64_t *del = task.mask(a, MASK_DEL);
+    result.resize(task.state_words());
+    for (uint32_t w = 0; w < task.state_words(); w++) {
+        result[w] = (state[w] & ~del[w]) | add[w];
+    }
+}
+
+// Apply only the add effects (empty-delete-list relaxation)
+inline void applyActionEDL(const TaskView &task, const PackedState &state, uint32_t a, PackedState &result)
+{
+    const uint64_t *add = task.mask(a, MASK_ADD);
+    result.resize(task.state_words());
+    for (uint32_t w = 0; w < task.state_words(); w++) {
+        result[w] = state[w] | add[w];
+    }
+}
+
+// Applicable actions of a state, found through the successor index
+void getApplicableActions(const TaskView &task, const PackedState &state, std::vector<uint32_t> &validActions);
+
+// Negative preconditions are ignored in the relaxed task
+void getApplicableActionsEDL(const TaskView &task, const PackedState &state, std::vector<uint32_t> &validActions);
+
+inline bool isGoal(const TaskView &task, const PackedState &state)
+{
+    for (uint32_t w = 0; w < task.state_words(); w++) {
+        if ((state[w] & task.goal_pos[w]) != task.goal_pos[w] || (state[w] & task.goal_neg[w]) != 0)
+            return false;
+    }
+    return true;
+}
+
+// Negative goals are ignored in the relaxed task, like negative preconditions
+inline bool isGoalEDL(const TaskView &task, const PackedState &state)
+{
+    for (uint32_t w = 0; w < task.state_words(); w++) {
+        if ((state[w] & task.goal_pos[w]) != task.goal_pos[w])
+            return false;
+    }
+    return true;
+}
+
+// Number of goal facts that are missing or, for negative goals, present
+inline uint32_t countUnsatisfiedGoals(const TaskView &task, const PackedState &state)
+{
+    uint32_t count = 0;
+    for (uint32_t w = 0; w < task.state_words(); w++)
+        count += __builtin_popcountll((task.goal_pos[w] & ~state[w]) | (task.goal_neg[w] & state[w]));
+    return count;
+}
+
+// Ground the environment into a flat task image. Action ids follow the order of allActions.
+std::vector<uint64_t> compileTask(const Env &env, const std::vector<GroundedAction> &allActions);
+
+// Copy a task image without the actions that are not kept; facts, initial state
+// and goal are unchanged, the remaining actions are renumbered in order
+std::vector<uint64_t> restrictTask(const TaskView &task, const std::vector<bool> &keepAction);
+
+// Point a view at a task image. The header, the bounds of every section, name
+// offsets, goal facts and the successor index are checked, so a truncated or
+// corrupted file is rejected; action masks and costs are taken as they are.
+bool bindTaskView(const void *data, size_t size, TaskView &view, std::string &error);
+
+bool writeTaskFile(const std::string &path, const std::vector<uint64_t> &image);
+
+// Memory-mapped compiled task; the view stays valid for the lifetime of the object
+class MappedTask
+{
+    void *data;
+    size_t size = 0;
+
+public:
+    TaskView view;
+
+    MappedTask();
+    ~MappedTask();
+    MappedTask(const MappedTask &) = delete;
+    MappedTask &operator=(const MappedTask &) = delete;
+
+    bool open(const std::string &path, std::string &error);
+};
+
+std::unordered_map<std::string, uint32_t> buildFactIndex(const TaskView &task);
+
+// A problem instance over a shared domain: the view keeps the domain's fact
+// table, action masks and successor index and only swaps in its own initial
+// state and goal. Not copyable, since the view points into the instance.
+struct TaskInstance
+{
+    TaskHeader header;
+    PackedState initial;
+    std::vector<uint32_t> goal;
+    std::vector<uint64_t> goal_masks;
+    TaskView view;
+    bool unreachable_goal = false;
+
+    TaskInstance(const TaskView &domain, const std::unordered_map<std::string, uint32_t> &factIndex,
+                 const std::set<std::string> &initialFacts, const std::set<std::string> &goalFacts);
+
+    TaskInstance(const TaskInstance &) = delete;
+    TaskInstance &operator=(const TaskInstance &) = delete;
+};
+
+#endif
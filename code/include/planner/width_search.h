@@ -0,0 +1,55 @@
+#ifndef PLANNER_WIDTH_SEARCH_H
+#define PLANNER_WIDTH_SEARCH_H
+
+#include "planner/search.h"
+#include "planner/task.h"
+
+#include <cstdint>
+#include <vector>
+
+// Width-based search on the grounded task. The novelty of a state is the size
+// of the smallest set of its facts that is true in it and in no state recorded
+// before; states that bring nothing new are what IW prunes and what BFWS puts
+// last. Neither reads the heuristic, and neither plan is optimal.
+
+// Facts and fact pairs recorded so far: one bit per fact, and for width 2 an
+// open-addressing hash set of pairs, so a lookup is a multiply and a probe
+class NoveltyTable
+{
+    uint32_t width;
+    std::vector<uint64_t> factBits;
+    std::vector<uint64_t> pairs; // (smaller fact + 1) << 32 | larger fact, 0 for empty slots
+    size_t pairCount = 0;
+    uint32_t shift = 64;
+
+    bool insertPair(uint64_t key);
+
+public:
+    NoveltyTable(uint32_t num_facts, uint32_t width);
+
+    // Record the tuples of a state whose facts (ascending) are facts and
+    // return its novelty, or width + 1 if nothing was new. Only tuples with a
+    // fact from fresh are considered: the rest were recorded with the parent.
+    uint32_t update(const std::vector<uint32_t> &facts, const std::vector<uint32_t> &fresh);
+
+    size_t pairs_seen() const { return pairCount; }
+};
+
+struct WidthSearchResult : SearchResult
+{
+    uint32_t width = 0; // the IW(k) that found the plan, 0 if BFWS did
+};
+
+// IW(1), IW(2), ... up to max_width: breadth-first search that prunes every
+// generated state of novelty above k, which needs no closed list since a state
+// seen before is never novel. IW is incomplete, so when every iteration fails
+// the search falls back to BFWS.
+WidthSearchResult iteratedWidthSearch(const TaskView &task, const SearchOptions &options, uint32_t max_width = 2);
+
+// Best-first width search: greedy search on (novelty, unsatisfied goals),
+// oldest first, with novelty 1, 2 or 3 measured among the states with the same
+// number of unsatisfied goals. Nothing is pruned but duplicates, so it is
+// complete.
+WidthSearchResult bestFirstWidthSearch(const TaskView &task, const SearchOptions &options);
+
+#endif
@@ -0,0 +1,352 @@
+#include "batch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <poll.h>
+#include <pthread.h>
+#include <regex>
+#include <set>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace std;
+
+// Queries share the grounded domain of one environment file and differ only in
+// their initial and goal conditions. Each query is two lines in the environment
+// file syntax:
+//   Initial conditions: On(A,B), On(B,Table), ...
+//   Goal conditions: On(B,A)
+// and is answered with one JSON line, in completion order.
+
+static string jsonEscape(const string &text)
+{
+    string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else if ((unsigned char)c >= 0x20) {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+// Destination of the answers of one query stream (stdout or a socket connection).
+// Workers write whole lines under the lock; a connection is closed once the
+// reader and every pending query have released it.
+struct BatchOutput
+{
+    int fd;
+    bool owns_fd;
+    mutex lock;
+
+    BatchOutput(int fd, bool owns_fd) : fd(fd), owns_fd(owns_fd) {}
+
+    ~BatchOutput()
+    {
+        if (owns_fd)
+            ::close(fd);
+    }
+
+    void writeLine(const string &line)
+    {
+        lock_guard<mutex> guard(lock);
+        string data = line + "\n";
+        size_t written = 0;
+        while (written < data.size()) {
+            ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+            if (n <= 0)
+                return; // reader went away
+            written += n;
+        }
+    }
+};
+
+struct BatchQuery
+{
+    long id;
+    set<string> initial;
+    set<string> goal;
+    shared_ptr<BatchOutput> output;
+};
+
+class BatchQueue
+{
+    mutex lock;
+    condition_variable ready;
+    deque<BatchQuery> queries;
+    bool closed = false;
+
+public:
+    void push(BatchQuery query)
+    {
+        {
+            lock_guard<mutex> guard(lock);
+            queries.push_back(std::move(query));
+        }
+        ready.notify_one();
+    }
+
+    // Blocks until a query is available; returns false once closed and drained
+    bool pop(BatchQuery &query)
+    {
+        unique_lock<mutex> guard(lock);
+        ready.wait(guard, [this] { return closed || !queries.empty(); });
+        if (queries.empty())
+            return false;
+        query = std::move(queries.front());
+        queries.pop_front();
+        return true;
+    }
+
+    void close()
+    {
+        {
+            lock_guard<mutex> guard(lock);
+            closed = true;
+        }
+        ready.notify_all();
+    }
+};
+
+static string solveQuery(const PlannerEngine &engine, const BatchQuery &query, HeuristicCache &heuristics)
+{
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    PlanResult result = engine.plan(query.initial, query.goal, &heuristics);
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
+
+    string json = "{\"id\":" + to_string(query.id);
+    json += ",\"status\":\"" + string(searchStatusName(result.status)) + "\"";
+    json += ",\"cost\":" + (result.solved() ? to_string(result.cost) : string("null"));
+    json += ",\"f_bound\":" + (std::isinf(result.f_bound) ? string("null") : to_string((long long)result.f_bound));
+    json += ",\"expanded\":" + to_string(result.states_expanded);
+    json += ",\"time_ms\":" + to_string(duration.count());
+    json += ",\"plan\":[";
+    for (size_t i = 0; i < result.plan.size(); i++) {
+        if (i > 0)
+            json += ",";
+        json += "\"" + jsonEscape(result.action_names[i]) + "\"";
+    }
+    json += "]}";
+    return json;
+}
+
+// Read queries from fd until end of input and hand them to the workers
+static void readQueries(int fd, shared_ptr<BatchOutput> output, BatchQueue &queue)
+{
+    static const regex initialConditionRegex("initialconditions:(.*)", regex::icase);
+    static const regex goalConditionRegex("goalconditions:(.*)", regex::icase);
+
+    long nextId = 1;
+    bool haveInitial = false;
+    set<string> initial;
+    string buffer;
+    char chunk[4096];
+
+    auto handleLine = [&](string line) {
+        string::iterator end_pos = remove_if(line.begin(), line.end(), [](char c) { return c == ' ' || c == '\r' || c == '\t'; });
+        line.erase(end_pos, line.end());
+        if (line.empty())
+            return;
+
+        smatch match;
+        if (regex_match(line, match, initialConditionRegex)) {
+            initial = parseConditionList(match[1].str());
+            haveInitial = true;
+        } else if (haveInitial && regex_match(line, match, goalConditionRegex)) {
+            queue.push(BatchQuery{nextId++, std::move(initial), parseConditionList(match[1].str()), output});
+            initial.clear();
+            haveInitial = false;
+        } else {
+            output->writeLine("{\"id\":" + to_string(nextId++) + ",\"status\":\"error\",\"message\":\"expected " +
+                              string(haveInitial ? "Goal" : "Initial") + " conditions, got: " + jsonEscape(line) + "\"}");
+            haveInitial = false;
+        }
+    };
+
+    ssize_t n;
+    while ((n = ::read(fd, chunk, sizeof(chunk))) > 0) {
+        buffer.append(chunk, n);
+        size_t pos;
+        while ((pos = buffer.find('\n')) != string::npos) {
+            handleLine(buffer.substr(0, pos));
+            buffer.erase(0, pos + 1);
+        }
+    }
+    // An interrupted read stops the batch; only a complete input ends with a last line
+    if (n == 0)
+        handleLine(buffer);
+}
+
+// Start a thread with SIGINT and SIGTERM blocked, so that they reach the main
+// thread and interrupt its read() or accept()
+template <typename Function>
+static thread startThread(Function function)
+{
+    sigset_t stopSignals, previous;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, &previous);
+    thread started(function);
+    pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+    return started;
+}
+
+// Socket connections being read, each by its own thread. Readers are joined,
+// never detached, so that none is left touching the list once stop() returns;
+// those that have finished are joined when the next one starts.
+class BatchClients
+{
+    mutex lock;
+    multiset<int> open; // a closed descriptor may come back before its reader is done
+    vector<thread> readers;
+    vector<thread::id> finished;
+
+    // Join the readers that have returned; the lock is held
+    void reap()
+    {
+        for (size_t i = 0; i < readers.size();) {
+            if (find(finished.begin(), finished.end(), readers[i].get_id()) == finished.end()) {
+                i++;
+                continue;
+            }
+            readers[i].join();
+            readers[i] = std::move(readers.back());
+            readers.pop_back();
+        }
+        finished.clear();
+    }
+
+public:
+    // Read the connection on a new thread with reader(fd)
+    template <typename Reader>
+    void start(int fd, Reader reader)
+    {
+        lock_guard<mutex> guard(lock);
+        reap();
+        open.insert(fd);
+        readers.push_back(startThread([this, fd, reader] {
+            reader(fd);
+            lock_guard<mutex> guard(lock);
+            open.erase(open.find(fd));
+            finished.push_back(this_thread::get_id());
+        }));
+    }
+
+    // Shut down the connections still being read and wait for their readers
+    void stop()
+    {
+        vector<thread> stopping;
+        {
+            lock_guard<mutex> guard(lock);
+            for (int fd : open)
+                shutdown(fd, SHUT_RD);
+            stopping.swap(readers);
+            finished.clear();
+        }
+        for (thread &reader : stopping)
+            reader.join();
+    }
+};
+
+int batchMain(const PlannerEngine &engine, unsigned workers, const string &socket_path)
+{
+    const TaskView &domain = engine.task();
+    if (workers == 0)
+        workers = max(1u, thread::hardware_concurrency());
+    cerr << "Batch mode: " << domain.num_facts() << " facts, " << domain.num_actions() << " actions, "
+         << workers << " workers" << endl;
+
+    // The socket is ready before any worker starts, so failing here leaves nothing to stop
+    int server = -1;
+    if (!socket_path.empty()) {
+        signal(SIGPIPE, SIG_IGN); // a client closing early must not kill the server
+
+        server = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (server < 0 || socket_path.size() >= sizeof(address.sun_path)) {
+            cerr << "Unable to create socket " << socket_path << endl;
+            if (server >= 0)
+                ::close(server);
+            return 1;
+        }
+        strcpy(address.sun_path, socket_path.c_str());
+        unlink(socket_path.c_str());
+        if (::bind(server, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || listen(server, 16) != 0) {
+            cerr << "Unable to listen on " << socket_path << endl;
+            ::close(server);
+            return 1;
+        }
+        cerr << "Listening on " << socket_path << endl;
+    }
+
+    BatchQueue queue;
+    vector<thread> pool;
+    for (unsigned i = 0; i < workers; i++) {
+        pool.push_back(startThread([&] {
+            HeuristicCache heuristics; // built by the first query, reused by the rest
+            BatchQuery query;
+            while (queue.pop(query)) {
+                string answer;
+                try {
+                    answer = solveQuery(engine, query, heuristics);
+                } catch (const exception &e) {
+                    // One bad query is answered with its error; the others go on
+                    answer = "{\"id\":" + to_string(query.id) + ",\"status\":\"error\",\"message\":\"" +
+                             jsonEscape(e.what()) + "\"}";
+                    heuristics = HeuristicCache(); // it may have been left mid-update
+                }
+                query.output->writeLine(answer);
+                query.output.reset();
+            }
+        }));
+    }
+
+    if (server < 0) {
+        readQueries(STDIN_FILENO, make_shared<BatchOutput>(STDOUT_FILENO, false), queue);
+    } else {
+        // Serve until SIGINT or SIGTERM cancels the engine; the poll timeout
+        // covers a signal arriving just before the wait
+        BatchClients clients;
+        while (!engine.cancelRequested()) {
+            pollfd waiting{server, POLLIN, 0};
+            if (poll(&waiting, 1, 500) <= 0)
+                continue;
+            int client = accept(server, nullptr, nullptr);
+            if (client < 0)
+                continue;
+            clients.start(client, [&queue](int fd) {
+                auto output = make_shared<BatchOutput>(fd, true);
+                readQueries(fd, output, queue);
+            });
+        }
+        ::close(server);
+        unlink(socket_path.c_str());
+        clients.stop();
+        cerr << "Stopped" << endl;
+    }
+
+    queue.close();
+    for (thread &worker : pool)
+        worker.join();
+    return 0;
+}
@@ -0,0 +1,12 @@
+#ifndef PLANNER_BATCH_H
+#define PLANNER_BATCH_H
+
+#include "planner/engine.h"
+
+#include <string>
+
+// Answer queries against the engine's grounded domain from stdin, or from every
+// client of a Unix socket when socket_path is given, on a pool of worker threads.
+int batchMain(const PlannerEngine &engine, unsigned workers, const std::string &socket_path);
+
+#endif
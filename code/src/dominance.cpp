@@ -0,0 +1,60 @@
+#include "planner/dominance.h"
+
+#include <algorithm>
+
+using namespace std;
+
+SupersetIndex::SupersetIndex() : nodes(1, Node{0, NONE, NONE, UINT32_MAX, false}) {}
+
+void SupersetIndex::insert(const vector<uint32_t> &facts, uint32_t cost)
+{
+    uint32_t node = 0;
+    nodes[0].minCost = min(nodes[0].minCost, cost);
+    for (uint32_t f : facts) {
+        // Find the child for f, or the link to put it in
+        uint32_t *link = &nodes[node].firstChild;
+        while (*link != NONE && nodes[*link].fact < f)
+            link = &nodes[*link].nextSibling;
+        if (*link != NONE && nodes[*link].fact == f) {
+            node = *link;
+            nodes[node].minCost = min(nodes[node].minCost, cost);
+            continue;
+        }
+        // link is not used once nodes grows, it may have moved
+        uint32_t next = nodes.size();
+        Node child{f, NONE, *link, cost, false};
+        *link = next;
+        nodes.push_back(child);
+        node = next;
+    }
+    if (!nodes[node].stored) {
+        nodes[node].stored = true;
+        count++;
+    }
+}
+
+// Every node lies on the path of a stored set, so once all query facts are
+// matched the sets below cover them
+bool SupersetIndex::coveredFrom(uint32_t node, const uint32_t *facts, const uint32_t *end, uint32_t cost,
+                                size_t &budget) const
+{
+    if (budget == 0 || nodes[node].minCost > cost)
+        return false;
+    budget--;
+    if (facts == end)
+        return true;
+    for (uint32_t child = nodes[node].firstChild; child != NONE; child = nodes[child].nextSibling) {
+        uint32_t fact = nodes[child].fact;
+        if (fact > *facts)
+            break;
+        if (coveredFrom(child, fact == *facts ? facts + 1 : facts, end, cost, budget))
+            return true;
+    }
+    return false;
+}
+
+bool SupersetIndex::containsSuperset(const vector<uint32_t> &facts, uint32_t cost, size_t max_visits) const
+{
+    size_t budget = max_visits;
+    return coveredFrom(0, facts.data(), facts.data() + facts.size(), cost, budget);
+}
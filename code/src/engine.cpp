@@ -0,0 +1,320 @@
+#include "planner/engine.h"
+#include "planner/frontier_search.h"
+#include "planner/invariants.h"
+#include "planner/lifted.h"
+#include "planner/plan.h"
+#include "planner/realtime_search.h"
+#include "planner/stubborn_sets.h"
+#include "planner/symmetry.h"
+#include "planner/width_search.h"
+
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+PlannerEngine::PlannerEngine(const PlannerConfig &config) : config(config), cancelled(false) {}
+
+void PlannerEngine::load(const Env &env)
+{
+    if (config.lifted) {
+        this->env.reset(new Env(env));
+        return;
+    }
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    vector<GroundedAction> allActions = generateAllGroundedActions(env);
+    image = compileTask(env, allActions);
+
+    string error;
+    if (!bindTaskView(image.data(), image.size() * sizeof(uint64_t), view, error)) {
+        throw runtime_error("Compiled task is invalid: " + error);
+    }
+    factIndex = buildFactIndex(view);
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    if (config.log)
+        *config.log << "Grounding time: "
+                    << std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count() << " ms" << endl;
+}
+
+bool PlannerEngine::loadTask(const string &path, string &error)
+{
+    mapped.reset(new MappedTask());
+    if (!mapped->open(path, error))
+        return false;
+    view = mapped->view;
+    factIndex = buildFactIndex(view);
+    return true;
+}
+
+SearchOptions PlannerEngine::searchOptions() const
+{
+    SearchOptions options = config;
+    options.cancel = &cancelled;
+    return options;
+}
+
+// Check the plan the search returned, then shorten and reorder it
+void PlannerEngine::finishPlan(const TaskView &task, PlanResult &result) const
+{
+    string error;
+    if (config.validate_plans && !validatePlan(task, result.plan, error))
+        throw runtime_error("Search returned an invalid plan: " + error);
+    if (!config.optimize_plans)
+        return;
+
+    result.redundant_actions = removeRedundantActions(task, result.plan);
+    result.makespan = reorderForMakespan(task, result.plan);
+    if (config.validate_plans && !validatePlan(task, result.plan, error))
+        throw runtime_error("Plan post-processing produced an invalid plan: " + error);
+    result.cost = 0;
+    for (uint32_t a : result.plan)
+        result.cost += task.action_cost(a);
+}
+
+// Dispatch on the configured pruning and print the statistics to the log
+PlanResult PlannerEngine::planTask(const TaskView &task, HeuristicCache *cache) const
+{
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    const SearchOptions options = searchOptions();
+    ostream *log = config.log;
+
+    if (log) {
+        *log << "Enable Heuristics: " << config.enable_heuristics << endl;
+        *log << "Max Effect Size: " << task.header->max_effect_size << endl;
+        if (!task.unit_costs())
+            *log << "Action Costs: " << task.header->min_action_cost << " to " << task.header->max_action_cost << endl;
+        if (config.width_search.empty()) {
+            *log << "Heuristic Function: " << config.heuristic_fn << endl;
+            *log << "Tie Breaking: " << config.tie_breaking << endl;
+            if (config.lookahead > 0)
+                *log << "Real-Time Lookahead: " << config.lookahead << endl;
+        } else {
+            *log << "Width Search: " << config.width_search << endl;
+        }
+    }
+
+    // With invariants, search a copy without the actions that never apply
+    TaskView searchTask = task;
+    vector<uint64_t> restricted;
+    vector<uint32_t> originalAction; // action ids of searchTask in task
+    unique_ptr<FiniteDomainEncoding> encoding;
+    bool goalUnreachable = false;
+    if (config.invariants) {
+        InvariantAnalysis invariants = analyzeInvariants(task);
+        restricted = restrictTask(task, invariants.reachable_action);
+        for (uint32_t a = 0; a < task.num_actions(); a++) {
+            if (invariants.reachable_action[a])
+                originalAction.push_back(a);
+        }
+        string error;
+        if (!bindTaskView(restricted.data(), restricted.size() * sizeof(uint64_t), searchTask, error))
+            throw runtime_error("Restricted task is invalid: " + error);
+        encoding.reset(new FiniteDomainEncoding(searchTask, invariants.groups));
+        goalUnreachable = invariants.goal_unreachable;
+        if (log) {
+            *log << "Mutex Groups: " << invariants.groups.size() << endl;
+            for (const MutexGroup &group : invariants.groups)
+                *log << "  " << group.name << " (" << group.facts.size() << " facts)" << endl;
+            *log << "Actions Pruned: " << invariants.pruned_actions << " of " << task.num_actions() << endl;
+            *log << "State Encoding: " << encoding->num_variables() << " variables, " << encoding->bits()
+                 << " bits (was " << task.num_facts() << ")" << endl;
+        }
+    }
+
+    PlanResult result;
+    if (goalUnreachable) {
+        result.f_bound = numeric_limits<float>::infinity();
+        if (log)
+            *log << "\nGoal is unreachable: it needs mutex facts or facts no action reaches";
+    } else if (config.frontier) {
+        FrontierSearchResult frontier = frontierSearch(searchTask, options);
+        static_cast<SearchResult &>(result) = frontier;
+        if (log)
+            *log << "\nPeak layer: " << frontier.peak_layer_states << " states, "
+                 << frontier.peak_layer_bytes / (1024.0 * 1024.0) << " MB in layer buffers"
+                 << (frontier.reversible ? "" : " (irreversible actions: every earlier layer kept)");
+    } else if (!config.width_search.empty()) {
+        WidthSearchResult width = config.width_search == "iw" ? iteratedWidthSearch(searchTask, options, config.max_width)
+                                                              : bestFirstWidthSearch(searchTask, options);
+        static_cast<SearchResult &>(result) = width;
+        if (log && width.solved())
+            *log << "\nSolved by: " << (width.width ? "IW(" + to_string(width.width) + ")" : string("BFWS"));
+    } else if (config.lookahead > 0) {
+        RealTimeResult realTime = realTimeSearch(searchTask, options, config.lookahead, config.trials, config.max_steps);
+        static_cast<SearchResult &>(result) = realTime;
+        if (log) {
+            for (size_t i = 0; i < realTime.trial_costs.size(); i++)
+                *log << "\nTrial " << i + 1 << ": executed cost " << realTime.trial_costs[i];
+            *log << "\nLearned h-values: " << realTime.learned_states;
+        }
+    } else if (config.symmetry) {
+        SymmetryGroup group = detectSymmetries(searchTask);
+        if (log) {
+            *log << "Symmetry Generators: " << group.generators.size() << endl;
+            for (const auto &orbit : group.object_orbits) {
+                *log << "  Interchangeable objects:";
+                for (const string &object : orbit)
+                    *log << " " << object;
+                *log << endl;
+            }
+        }
+        static_cast<SearchResult &>(result) = symmetricAstar(searchTask, group, options);
+    } else if (config.stubborn_sets) {
+        StubbornSets stubbornSets(searchTask);
+        if (encoding) {
+            static_cast<SearchResult &>(result) = compactAstar(searchTask, *encoding, options, &stubbornSets);
+        } else {
+            GroundedSpace space(searchTask, options, cache);
+            space.stubborn_sets = &stubbornSets;
+            static_cast<SearchResult &>(result) = astarSearch(space, options);
+        }
+        if (log)
+            *log << "\nStubborn sets pruned " << stubbornSets.applicable_pruned << " of "
+                 << stubbornSets.applicable_total << " applicable actions";
+    } else if (encoding) {
+        static_cast<SearchResult &>(result) = compactAstar(searchTask, *encoding, options);
+    } else {
+        static_cast<SearchResult &>(result) = astar(searchTask, options, cache);
+    }
+
+    for (uint32_t &a : result.plan) {
+        if (config.invariants)
+            a = originalAction[a];
+    }
+    if (result.solved())
+        finishPlan(task, result);
+    for (uint32_t a : result.plan) {
+        result.action_names.push_back(task.action_name(a));
+    }
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    result.time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+
+    // Print timing and statistics
+    if (log) {
+        *log << "\n\nPlanning Statistics:" << endl;
+        *log << "Time taken: " << result.time_ms << " ms" << endl;
+        *log << "Status: " << searchStatusName(result.status) << endl;
+        *log << "Lower bound: " << result.f_bound << endl;
+        *log << "States expanded: " << result.states_expanded << endl;
+        *log << "States generated: " << result.states_generated << endl;
+        if (config.reopen_closed)
+            *log << "States reopened: " << result.states_reopened << endl;
+        if (result.solved())
+            *log << "Plan cost: " << result.cost << endl;
+        if (result.solved() && config.optimize_plans) {
+            *log << "Redundant actions removed: " << result.redundant_actions << endl;
+            *log << "Makespan: " << result.makespan << endl;
+        }
+    }
+    return result;
+}
+
+PlanResult PlannerEngine::plan() const
+{
+    if (!config.lifted) {
+        if (!view.header)
+            throw runtime_error("No task loaded");
+        return planTask(view);
+    }
+    if (!env)
+        throw runtime_error("No environment loaded");
+    if (config.heuristic_fn == "hadd" || config.heuristic_fn == "hmax")
+        throw runtime_error("Lifted search supports the edl and ham heuristics only");
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    ostream *log = config.log;
+
+    if (log) {
+        *log << "Enable Heuristics: " << config.enable_heuristics << endl;
+        *log << "Heuristic Function: " << config.heuristic_fn << endl;
+        *log << "Tie Breaking: " << config.tie_breaking << endl;
+        *log << "Successor Generation: lifted" << endl;
+    }
+
+    LiftedSearchResult lifted = liftedSearch(*env, searchOptions());
+    PlanResult result;
+    static_cast<SearchResult &>(result) = lifted;
+    result.action_names = lifted.action_names;
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    result.time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+
+    if (log) {
+        *log << "\n\nPlanning Statistics:" << endl;
+        *log << "Time taken: " << result.time_ms << " ms" << endl;
+        *log << "Status: " << searchStatusName(result.status) << endl;
+        *log << "Lower bound: " << result.f_bound << endl;
+        *log << "States expanded: " << result.states_expanded << endl;
+        *log << "States generated: " << result.states_generated << endl;
+        if (config.reopen_closed)
+            *log << "States reopened: " << result.states_reopened << endl;
+        if (result.solved())
+            *log << "Plan cost: " << result.cost << endl;
+        *log << "Facts interned: " << lifted.facts_interned << endl;
+        *log << "Groundings interned: " << lifted.groundings_interned << endl;
+    }
+    return result;
+}
+
+PlanResult PlannerEngine::replan(const set<string> &initial)
+{
+    if (!view.header)
+        throw runtime_error("Replanning needs a grounded task");
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    // Facts outside the fact table are not used by any action
+    PackedState start(view.state_words(), 0);
+    for (const string &fact : initial) {
+        auto it = factIndex.find(fact);
+        if (it != factIndex.end())
+            start[it->second / 64] |= uint64_t(1) << (it->second % 64);
+    }
+    if (!incremental)
+        incremental.reset(new IncrementalSearch(view, searchOptions()));
+    IncrementalResult incrementalResult = incremental->plan(start);
+    PlanResult result;
+    static_cast<SearchResult &>(result) = incrementalResult;
+
+    // The loaded task with this initial state, for validation and post-processing
+    TaskView startView = view;
+    startView.initial = start.data();
+    if (result.solved())
+        finishPlan(startView, result);
+    for (uint32_t a : result.plan)
+        result.action_names.push_back(view.action_name(a));
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    result.time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+
+    if (config.log) {
+        ostream &log = *config.log;
+        log << "Replan: " << searchStatusName(result.status) << ", " << result.time_ms << " ms, "
+            << result.states_expanded << " states expanded";
+        if (result.solved())
+            log << ", plan cost " << result.cost << (incrementalResult.joined ? ", joined an earlier plan" : "");
+        log << "; " << incrementalResult.known_states << " states known, " << incrementalResult.solved_states
+            << " with exact distances" << endl;
+    }
+    return result;
+}
+
+PlanResult PlannerEngine::plan(const set<string> &initial, const set<string> &goal, HeuristicCache *cache) const
+{
+    if (!view.header)
+        throw runtime_error("Instance queries need a grounded task");
+
+    TaskInstance instance(view, factIndex, initial, goal);
+    if (instance.unreachable_goal) {
+        PlanResult result;
+        result.f_bound = numeric_limits<float>::infinity();
+        return result;
+    }
+    return planTask(instance.view, cache);
+}
@@ -0,0 +1,424 @@
+#include "planner/env.h"
+#include "planner/profiling.h"
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <regex>
+
+#define SYMBOLS 0
+#define INITIAL 1
+#define GOAL 2
+#define ACTIONS 3
+#define ACTION_DEFINITION 4
+#define ACTION_PRECONDITION 5
+#define ACTION_EFFECT 6
+#define ACTION_COST 7
+
+using namespace std;
+
+list<string> parse_symbols(string symbols_str)
+{
+    list<string> symbols;
+    size_t pos = 0;
+    string delimiter = ",";
+    while ((pos = symbols_str.find(delimiter)) != string::npos)
+    {
+        string symbol = symbols_str.substr(0, pos);
+        symbols_str.erase(0, pos + delimiter.length());
+        symbols.push_back(symbol);
+    }
+    symbols.push_back(symbols_str);
+    return symbols;
+}
+
+Env *create_env(char *filename)
+{
+    PROFILE_SCOPE("parse");
+    ifstream input_file(filename);
+    unique_ptr<Env> env(new Env()); // not leaked when a section is malformed
+    regex symbolStateRegex("symbols:", regex::icase);
+    regex symbolRegex("([a-zA-Z0-9_, ]+) *");
+    regex initialConditionRegex("initialconditions:(.*)", regex::icase);
+    regex conditionRegex("(!?[A-Z][a-zA-Z_]*) *\\( *([a-zA-Z0-9_, ]+) *\\)");
+    regex goalConditionRegex("goalconditions:(.*)", regex::icase);
+    regex actionRegex("actions:", regex::icase);
+    regex precondRegex("preconditions:(.*)", regex::icase);
+    regex effectRegex("effects:(.*)", regex::icase);
+    regex costRegex("cost:([0-9]+)", regex::icase);
+    int parser = SYMBOLS;
+
+    unordered_set<Condition, ConditionHasher, ConditionComparator> preconditions;
+    unordered_set<Condition, ConditionHasher, ConditionComparator> effects;
+    string action_name;
+    string action_args;
+    auto add_action = [&](uint32_t cost) {
+        env->add_action(
+            Action(action_name, parse_symbols(action_args), preconditions, effects, cost));
+
+        preconditions.clear();
+        effects.clear();
+    };
+
+    string line;
+    if (input_file.is_open())
+    {
+        while (getline(input_file, line))
+        {
+            string::iterator end_pos = remove(line.begin(), line.end(), ' ');
+            line.erase(end_pos, line.end());
+
+            if (line.empty())
+                continue;
+
+            // The cost line after the effects is optional; actions cost 1 by default
+            if (parser == ACTION_COST)
+            {
+                smatch results;
+                bool has_cost = regex_match(line, results, costRegex);
+                uint64_t cost = 1;
+                if (has_cost)
+                {
+                    // Digit by digit, so that no value wraps before the check
+                    cost = 0;
+                    for (char digit : results[1].str())
+                    {
+                        cost = cost * 10 + (digit - '0');
+                        if (cost > MAX_ACTION_COST)
+                            throw runtime_error("Cost of action " + action_name + " is above " +
+                                                to_string(MAX_ACTION_COST));
+                    }
+                }
+                add_action((uint32_t)cost);
+                parser = ACTION_DEFINITION;
+                if (has_cost)
+                    continue;
+            }
+
+            if (parser == SYMBOLS)
+            {
+                smatch results;
+                if (regex_search(line, results, symbolStateRegex))
+                {
+                    line = line.substr(8);
+                    sregex_token_iterator iter(line.begin(), line.end(), symbolRegex, 0);
+                    sregex_token_iterator end;
+
+                    env->add_symbols(parse_symbols(iter->str())); // fixed
+
+                    parser = INITIAL;
+                }
+                else
+                {
+                    throw runtime_error("Symbols: expected the symbol list, got \"" + line + "\"");
+                }
+            }
+            else if (parser == INITIAL)
+            {
+                const char *line_c = line.c_str();
+                if (regex_match(line_c, initialConditionRegex))
+                {
+                    const std::vector<int> submatches = {1, 2};
+                    sregex_token_iterator iter(
+                        line.begin(), line.end(), conditionRegex, submatches);
+                    sregex_token_iterator end;
+
+                    while (iter != end)
+                    {
+                        // name
+                        string predicate = iter->str();
+                        iter++;
+                        // args
+                        string args = iter->str();
+                        iter++;
+
+                        if (predicate[0] == '!')
+                        {
+                            env->remove_initial_condition(
+                                GroundedCondition(predicate.substr(1), parse_symbols(args)));
+                        }
+                        else
+                        {
+                            env->add_initial_condition(
+                                GroundedCondition(predicate, parse_symbols(args)));
+                        }
+                    }
+
+                    parser = GOAL;
+                }
+                else
+                {
+                    throw runtime_error("Initial conditions: expected the initial state, got \"" + line + "\"");
+                }
+            }
+            else if (parser == GOAL)
+            {
+                const char *line_c = line.c_str();
+                if (regex_match(line_c, goalConditionRegex))
+                {
+                    const std::vector<int> submatches = {1, 2};
+                    sregex_token_iterator iter(
+                        line.begin(), line.end(), conditionRegex, submatches);
+                    sregex_token_iterator end;
+
+                    while (iter != end)
+                    {
+                        // name
+                        string predicate = iter->str();
+                        iter++;
+                        // args
+                        string args = iter->str();
+                        iter++;
+
+                        if (predicate[0] == '!')
+                        {
+                            env->remove_goal_condition(
+                                GroundedCondition(predicate.substr(1), parse_symbols(args)));
+                        }
+                        else
+                        {
+                            env->add_goal_condition(
+                                GroundedCondition(predicate, parse_symbols(args)));
+                        }
+                    }
+
+                    parser = ACTIONS;
+                }
+                else
+                {
+                    throw runtime_error("Goal conditions: expected the goal, got \"" + line + "\"");
+                }
+            }
+            else if (parser == ACTIONS)
+            {
+                const char *line_c = line.c_str();
+                if (regex_match(line_c, actionRegex))
+                {
+                    parser = ACTION_DEFINITION;
+                }
+                else
+                {
+                    throw runtime_error("Actions: expected the Actions: line, got \"" + line + "\"");
+                }
+            }
+            else if (parser == ACTION_DEFINITION)
+            {
+                const char *line_c = line.c_str();
+                if (regex_match(line_c, conditionRegex))
+                {
+                    const std::vector<int> submatches = {1, 2};
+                    sregex_token_iterator iter(
+                        line.begin(), line.end(), conditionRegex, submatches);
+                    sregex_token_iterator end;
+                    // name
+                    action_name = iter->str();
+                    iter++;
+                    // args
+                    action_args = iter->str();
+                    iter++;
+
+                    parser = ACTION_PRECONDITION;
+                }
+                else
+                {
+                    throw runtime_error("Actions: expected an action such as Move(x,y), got \"" + line + "\"");
+                }
+            }
+            else if (parser == ACTION_PRECONDITION)
+            {
+                const char *line_c = line.c_str();
+                if (regex_match(line_c, precondRegex))
+                {
+                    const std::vector<int> submatches = {1, 2};
+                    sregex_token_iterator iter(
+                        line.begin(), line.end(), conditionRegex, submatches);
+                    sregex_token_iterator end;
+
+                    while (iter != end)
+                    {
+                        // name
+                        string predicate = iter->str();
+                        iter++;
+                        // args
+                        string args = iter->str();
+                        iter++;
+
+                        bool truth;
+
+                        if (predicate[0] == '!')
+                        {
+                            predicate = predicate.substr(1);
+                            truth = false;
+                        }
+                        else
+                        {
+                            truth = true;
+                        }
+
+                        Condition precond(predicate, parse_symbols(args), truth);
+                        preconditions.insert(precond);
+                    }
+
+                    parser = ACTION_EFFECT;
+                }
+                else
+                {
+                    throw runtime_error("Preconditions of " + action_name + ": expected the preconditions, got \"" + line + "\"");
+                }
+            }
+            else if (parser == ACTION_EFFECT)
+            {
+                const char *line_c = line.c_str();
+                if (regex_match(line_c, effectRegex))
+                {
+                    const std::vector<int> submatches = {1, 2};
+                    sregex_token_iterator iter(
+                        line.begin(), line.end(), conditionRegex, submatches);
+                    sregex_token_iterator end;
+
+                    while (iter != end)
+                    {
+                        // name
+                        string predicate = iter->str();
+                        iter++;
+                        // args
+                        string args = iter->str();
+                        iter++;
+
+                        bool truth;
+
+                        if (predicate[0] == '!')
+                        {
+                            predicate = predicate.substr(1);
+                            truth = false;
+                        }
+                        else
+                        {
+                            truth = true;
+                        }
+
+                        Condition effect(predicate, parse_symbols(args), truth);
+                        effects.insert(effect);
+                    }
+
+                    parser = ACTION_COST;
+                }
+                else
+                {
+                    throw runtime_error("Effects of " + action_name + ": expected the effects, got \"" + line + "\"");
+                }
+            }
+        }
+        if (parser == ACTION_COST)
+            add_action(1);
+        input_file.close();
+    }
+
+    else
+        throw runtime_error(string("Unable to open file ") + filename);
+
+    return env.release();
+}
+
+void generateGroundedCombinations(
+    Action action,
+    vector<string> currArgs,
+    vector<GroundedAction> &groundedActions,
+    unordered_set<string> symbols,
+    int nArgs
+)
+{
+    if (currArgs.size() == nArgs)
+    {
+        // Build mapping from action parameter names to grounded argument values
+        list<string> paramList = action.get_args();
+        vector<string> params(paramList.begin(), paramList.end());
+        vector<string> groundedArgs = currArgs; // same order as params
+
+        // Grounded preconditions/effects
+        unordered_set<GroundedCondition, GroundedConditionHasher, GroundedConditionComparator> gPreconds;
+        unordered_set<GroundedCondition, GroundedConditionHasher, GroundedConditionComparator> gEffects;
+
+        // Ground each precondition by substituting parameters with groundedArgs
+        for (const Condition &cond : action.get_preconditions()) {
+            list<string> condArgs = cond.get_args();
+            list<string> groundedCondArgs;
+            for (const string &a : condArgs) {
+                // find if 'a' is one of the parameters; if so, substitute
+                auto it = find(params.begin(), params.end(), a);
+                if (it != params.end()) {
+                    int idx = distance(params.begin(), it);
+                    groundedCondArgs.push_back(groundedArgs[idx]);
+                } else {
+                    groundedCondArgs.push_back(a);
+                }
+            }
+            gPreconds.insert(GroundedCondition(cond.get_predicate(), groundedCondArgs, cond.get_truth()));
+        }
+
+        // Ground each effect similarly
+        for (const Condition &cond : action.get_effects()) {
+            list<string> condArgs = cond.get_args();
+            list<string> groundedCondArgs;
+            for (const string &a : condArgs) {
+                auto it = find(params.begin(), params.end(), a);
+                if (it != params.end()) {
+                    int idx = distance(params.begin(), it);
+                    groundedCondArgs.push_back(groundedArgs[idx]);
+                } else {
+                    groundedCondArgs.push_back(a);
+                }
+            }
+            gEffects.insert(GroundedCondition(cond.get_predicate(), groundedCondArgs, cond.get_truth()));
+        }
+
+        groundedActions.push_back(GroundedAction(action.get_name(), list<string>(currArgs.begin(), currArgs.end()), gPreconds, gEffects,
+                                                action.get_cost()));
+        return;
+    }
+
+    for (const string &symbol : symbols)
+    {
+        currArgs.push_back(symbol);
+        unordered_set<string> remainingSymbols = symbols;
+        remainingSymbols.erase(symbol);
+        generateGroundedCombinations(action, currArgs, groundedActions, remainingSymbols, nArgs);
+        currArgs.pop_back();
+    }
+}
+
+std::vector<GroundedAction> generateAllGroundedActions(const Env &env) {
+    PROFILE_SCOPE("ground");
+    std::vector<GroundedAction> groundedActions;
+    unordered_set<Action, ActionHasher, ActionComparator> actions = env.get_actions();
+    unordered_set<string> symbols = env.get_symbols();
+
+    for (const Action &action : actions) {
+        vector<string> currArgs;
+        int nArgs = action.get_args().size();
+        generateGroundedCombinations(action, currArgs, groundedActions, symbols, nArgs);
+    }
+
+    return groundedActions;
+}
+
+// Collect the facts of a condition list; "!" entries remove a fact, as in create_env
+set<string> parseConditionList(const string &conditions)
+{
+    static const regex conditionRegex("(!?[A-Z][a-zA-Z_]*) *\\( *([a-zA-Z0-9_, ]+) *\\)");
+    set<string> facts;
+    const std::vector<int> submatches = {1, 2};
+    sregex_token_iterator iter(conditions.begin(), conditions.end(), conditionRegex, submatches);
+    sregex_token_iterator end;
+    while (iter != end) {
+        string predicate = iter->str();
+        iter++;
+        string args = iter->str();
+        iter++;
+        if (predicate[0] == '!')
+            facts.erase(GroundedCondition(predicate.substr(1), parse_symbols(args)).toString());
+        else
+            facts.insert(GroundedCondition(predicate, parse_symbols(args)).toString());
+    }
+    return facts;
+}
@@ -0,0 +1,394 @@
+#include "planner/frontier_search.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+
+using namespace std;
+
+// One breadth-first layer: states of `words` 64-bit words each, appended in
+// generation order and normalized (sorted, duplicates removed) on demand. The
+// unsorted tail is merged in whenever it outgrows the sorted part, so a layer
+// under construction holds at most about twice its distinct states.
+class StateLayer
+{
+    static const int MIN_UNSORTED = 1 << 16;
+
+    uint32_t words;
+    vector<uint64_t> data;
+    size_t sorted = 0; // states [0, sorted) are sorted and unique
+
+    bool less(const uint64_t *a, const uint64_t *b) const
+    {
+        for (uint32_t w = 0; w < words; w++) {
+            if (a[w] != b[w])
+                return a[w] < b[w];
+        }
+        return false;
+    }
+
+    bool equal(const uint64_t *a, const uint64_t *b) const
+    {
+        return memcmp(a, b, words * sizeof(uint64_t)) == 0;
+    }
+
+public:
+    explicit StateLayer(uint32_t words) : words(words) {}
+
+    size_t size() const { return data.size() / words; }
+    size_t bytes() const { return data.capacity() * sizeof(uint64_t); }
+    const uint64_t *state(size_t i) const { return data.data() + i * words; }
+
+    void push(const uint64_t *state)
+    {
+        data.insert(data.end(), state, state + words);
+        if (size() - sorted > max(sorted, (size_t)MIN_UNSORTED))
+            normalize();
+    }
+
+    // Sort the tail and merge it into the sorted part, dropping duplicates
+    void normalize()
+    {
+        PROFILE_SCOPE("layer_sort");
+        size_t n = size();
+        if (sorted == n)
+            return;
+
+        vector<size_t> tail(n - sorted);
+        iota(tail.begin(), tail.end(), sorted);
+        sort(tail.begin(), tail.end(), [this](size_t a, size_t b) { return less(state(a), state(b)); });
+
+        vector<uint64_t> merged;
+        merged.reserve(data.size());
+        auto append = [&](const uint64_t *s) {
+            if (merged.empty() || !equal(merged.data() + merged.size() - words, s))
+                merged.insert(merged.end(), s, s + words);
+        };
+        size_t i = 0, j = 0;
+        while (i < sorted || j < tail.size()) {
+            if (j == tail.size() || (i < sorted && !less(state(tail[j]), state(i))))
+                append(state(i++));
+            else
+                append(state(tail[j++]));
+        }
+        data.swap(merged);
+        sorted = size();
+    }
+
+    // Remove the states of other from this layer; both must be normalized
+    void subtract(const StateLayer &other)
+    {
+        PROFILE_SCOPE("layer_subtract");
+        size_t kept = 0, j = 0;
+        for (size_t i = 0; i < size(); i++) {
+            const uint64_t *s = state(i);
+            while (j < other.size() && less(other.state(j), s))
+                j++;
+            if (j < other.size() && equal(other.state(j), s))
+                continue;
+            if (kept != i)
+                copy(s, s + words, data.begin() + kept * words);
+            kept++;
+        }
+        data.resize(kept * words);
+        sorted = kept;
+    }
+
+    // Add the states of other; both must be normalized
+    void merge(const StateLayer &other)
+    {
+        PROFILE_SCOPE("layer_merge");
+        vector<uint64_t> merged;
+        merged.reserve(data.size() + other.data.size());
+        size_t i = 0, j = 0;
+        while (i < size() || j < other.size()) {
+            const uint64_t *s;
+            if (j == other.size() || (i < size() && !less(other.state(j), state(i)))) {
+                s = state(i++);
+                if (j < other.size() && equal(s, other.state(j)))
+                    j++;
+            } else {
+                s = other.state(j++);
+            }
+            merged.insert(merged.end(), s, s + words);
+        }
+        data.swap(merged);
+        sorted = size();
+    }
+
+    void clear()
+    {
+        data.clear();
+        sorted = 0;
+    }
+
+    void swap(StateLayer &other)
+    {
+        data.swap(other.data);
+        std::swap(sorted, other.sorted);
+    }
+};
+
+// Whether every action can be undone: from each state where action a applies,
+// some action b applies after it and leads back. A successor of layer d then
+// lies in layer d - 1, d or d + 1, so comparing with the two previous layers
+// removes every duplicate. The test is sufficient, not exact: a may only change
+// facts its preconditions fix, and b must hold after a and restore exactly
+// those facts without touching any other fact whose value is unknown. Static
+// facts keep their initial value, and actions needing another value are skipped.
+static bool everyActionReversible(const TaskView &task)
+{
+    const uint32_t words = task.state_words();
+    vector<vector<uint32_t>> adders(task.num_facts()), deleters(task.num_facts());
+    vector<uint64_t> changing(words, 0), staticTrue(words), staticFalse(words);
+    for (uint32_t a = 0; a < task.num_actions(); a++) {
+        const uint64_t *add = task.mask(a, MASK_ADD), *del = task.mask(a, MASK_DEL);
+        for (uint32_t w = 0; w < words; w++) {
+            changing[w] |= add[w] | del[w];
+            for (uint64_t bits = add[w]; bits; bits &= bits - 1)
+                adders[w * 64 + __builtin_ctzll(bits)].push_back(a);
+            for (uint64_t bits = del[w] & ~add[w]; bits; bits &= bits - 1)
+                deleters[w * 64 + __builtin_ctzll(bits)].push_back(a);
+        }
+    }
+
+    for (uint32_t w = 0; w < words; w++) {
+        staticTrue[w] = task.initial[w] & ~changing[w];
+        staticFalse[w] = ~task.initial[w] & ~changing[w];
+    }
+    auto neverApplies = [&](uint32_t a) {
+        const uint64_t *pos = task.mask(a, MASK_PRE_POS), *neg = task.mask(a, MASK_PRE_NEG);
+        for (uint32_t w = 0; w < words; w++) {
+            if ((pos[w] & (staticFalse[w] | neg[w])) || (neg[w] & staticTrue[w]))
+                return true;
+        }
+        return false;
+    };
+
+    vector<uint64_t> madeTrue(words), madeFalse(words), afterTrue(words), afterFalse(words);
+    for (uint32_t a = 0; a < task.num_actions(); a++) {
+        if (neverApplies(a))
+            continue;
+        const uint64_t *pos = task.mask(a, MASK_PRE_POS), *neg = task.mask(a, MASK_PRE_NEG);
+        const uint64_t *add = task.mask(a, MASK_ADD), *del = task.mask(a, MASK_DEL);
+        int64_t changed = -1; // some fact a changes, by its index
+        bool restoresTrue = false; // b must add it back, else delete it
+        for (uint32_t w = 0; w < words; w++) {
+            madeTrue[w] = add[w] & ~pos[w];
+            madeFalse[w] = del[w] & ~add[w] & ~neg[w];
+            // A fact set whose earlier value is unknown cannot be restored
+            if ((madeTrue[w] & ~neg[w]) || (madeFalse[w] & ~pos[w]))
+                return false;
+            afterTrue[w] = (pos[w] & ~del[w]) | add[w] | staticTrue[w];
+            afterFalse[w] = (neg[w] & ~add[w]) | (del[w] & ~add[w]) | staticFalse[w];
+            if (changed < 0 && madeFalse[w]) {
+                changed = w * 64 + __builtin_ctzll(madeFalse[w]);
+                restoresTrue = true;
+            } else if (changed < 0 && madeTrue[w]) {
+                changed = w * 64 + __builtin_ctzll(madeTrue[w]);
+            }
+        }
+        if (changed < 0)
+            continue; // changes nothing
+
+        bool undone = false;
+        for (uint32_t b : restoresTrue ? adders[changed] : deleters[changed]) {
+            const uint64_t *bPos = task.mask(b, MASK_PRE_POS), *bNeg = task.mask(b, MASK_PRE_NEG);
+            const uint64_t *bAdd = task.mask(b, MASK_ADD), *bDel = task.mask(b, MASK_DEL);
+            bool inverse = true;
+            for (uint32_t w = 0; w < words && inverse; w++) {
+                uint64_t bDeleted = bDel[w] & ~bAdd[w];
+                inverse = (bPos[w] & ~afterTrue[w]) == 0 && (bNeg[w] & ~afterFalse[w]) == 0 &&
+                          (bAdd[w] & ~pos[w]) == 0 && (bDeleted & ~neg[w]) == 0 &&
+                          (madeFalse[w] & ~bAdd[w]) == 0 && (madeTrue[w] & ~bDeleted) == 0;
+            }
+            if (inverse) {
+                undone = true;
+                break;
+            }
+        }
+        if (!undone)
+            return false;
+    }
+    return true;
+}
+
+// Breadth-first search that keeps the current layer and the one before it, and
+// in a task that is not reversible every older layer as well
+class LayeredBFS
+{
+    const TaskView &task;
+    SearchGuard guard;
+    ProgressReporter *progress;
+    vector<uint32_t> applicable;
+    PackedState state, successor;
+
+public:
+    enum Outcome
+    {
+        LAYER_DONE,
+        GOAL_FOUND,
+        STOPPED
+    };
+
+    StateLayer previous, current, next;
+    StateLayer older; // layers before previous, only filled when not reversible
+    const bool reversible;
+    int depth = 0; // distance of the states in current
+    uint64_t expanded = 0, generated = 0;
+
+    LayeredBFS(const TaskView &task, const SearchOptions &options, ProgressReporter *progress, bool reversible)
+        : task(task), guard(options), progress(progress), previous(task.state_words()), current(task.state_words()),
+          next(task.state_words()), older(task.state_words()), reversible(reversible)
+    {
+        PackedState initial = task.initial_state();
+        current.push(initial.data());
+    }
+
+    // Expand the current layer into the next one. With goal_check, stop at the
+    // first generated goal state and report the state and action that reached it.
+    Outcome expand(bool goal_check, SearchStatus &status, PackedState &goalParent, uint32_t &goalAction)
+    {
+        next.clear();
+        for (size_t i = 0; i < current.size(); i++) {
+            if (guard.exceeded(expanded, status))
+                return STOPPED;
+
+            state.assign(current.state(i), current.state(i) + task.state_words());
+            expanded++;
+            PROFILE_COUNT("expansions", 1);
+            if (progress)
+                progress->tick(expanded, generated, current.size() - i + next.size(), older.size() + previous.size() + i,
+                               depth, 0);
+
+            getApplicableActions(task, state, applicable);
+            for (uint32_t a : applicable) {
+                applyAction(task, state, a, successor);
+                generated++;
+                if (goal_check && isGoal(task, successor)) {
+                    goalParent = state;
+                    goalAction = a;
+                    return GOAL_FOUND;
+                }
+                next.push(successor.data());
+            }
+        }
+
+        // Successors of layer d that are new lie in layer d + 1; drop the ones
+        // in d and d - 1, and when actions cannot all be undone the older ones
+        next.normalize();
+        next.subtract(current);
+        next.subtract(previous);
+        if (!reversible) {
+            next.subtract(older);
+            older.merge(previous);
+        }
+        previous.swap(current);
+        current.swap(next);
+        depth++;
+        return LAYER_DONE;
+    }
+
+    size_t bytes() const { return previous.bytes() + current.bytes() + next.bytes() + older.bytes(); }
+};
+
+// Find a state of layer with an action leading to target; target becomes that state
+static bool stepBack(const TaskView &task, const StateLayer &layer, PackedState &target, vector<uint32_t> &reversedPlan)
+{
+    PackedState state, successor;
+    vector<uint32_t> applicable;
+    for (size_t i = 0; i < layer.size(); i++) {
+        state.assign(layer.state(i), layer.state(i) + task.state_words());
+        getApplicableActions(task, state, applicable);
+        for (uint32_t a : applicable) {
+            applyAction(task, state, a, successor);
+            if (successor == target) {
+                reversedPlan.push_back(a);
+                target.swap(state);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+FrontierSearchResult frontierSearch(const TaskView &task, const SearchOptions &options)
+{
+    if (!task.unit_costs())
+        throw runtime_error("Frontier search needs every action to cost 1");
+
+    FrontierSearchResult result;
+    if (isGoal(task, task.initial_state())) {
+        result.status = SEARCH_SOLVED;
+        return result;
+    }
+
+    unique_ptr<ProgressReporter> progress;
+    if (options.progress_format != "off")
+        progress.reset(new ProgressReporter(options.progress_format, options.progress_interval_ms));
+
+    result.reversible = everyActionReversible(task);
+    LayeredBFS bfs(task, options, progress.get(), result.reversible);
+    PackedState target;
+    uint32_t lastAction = 0;
+    while (true) {
+        result.peak_layer_states = max(result.peak_layer_states, bfs.current.size());
+        LayeredBFS::Outcome outcome = bfs.expand(true, result.status, target, lastAction);
+        result.peak_layer_bytes = max(result.peak_layer_bytes, bfs.bytes());
+        result.states_expanded = bfs.expanded;
+        result.states_generated = bfs.generated;
+
+        if (outcome == LayeredBFS::STOPPED) {
+            // No state up to the current depth is a goal
+            result.f_bound = bfs.depth + 1;
+            return result;
+        }
+        if (outcome == LayeredBFS::GOAL_FOUND)
+            break;
+        if (bfs.current.size() == 0) {
+            result.status = SEARCH_UNSOLVABLE;
+            result.f_bound = numeric_limits<float>::infinity();
+            return result;
+        }
+    }
+
+    // target is in layer depth, the goal one step further. Step back through
+    // the layer still in memory, then search again for the older ones; every
+    // search to depth k yields layers k and k - 1.
+    const int cost = bfs.depth + 1;
+    result.f_bound = cost;
+    result.cost = cost;
+    vector<uint32_t> reversedPlan(1, lastAction);
+    int targetDepth = bfs.depth;
+    if (targetDepth > 0) {
+        if (!stepBack(task, bfs.previous, target, reversedPlan))
+            throw runtime_error("Unable to rebuild the frontier search plan");
+        targetDepth--;
+    }
+
+    SearchOptions replay = options;
+    replay.limits = SearchLimits();
+    PackedState unusedState;
+    uint32_t unusedAction;
+    while (targetDepth > 0) {
+        LayeredBFS again(task, replay, nullptr, result.reversible);
+        while (again.depth < targetDepth - 1) {
+            if (again.expand(false, result.status, unusedState, unusedAction) == LayeredBFS::STOPPED)
+                return result;
+        }
+        if (!stepBack(task, again.current, target, reversedPlan))
+            throw runtime_error("Unable to rebuild the frontier search plan");
+        targetDepth--;
+        if (targetDepth > 0) {
+            if (!stepBack(task, again.previous, target, reversedPlan))
+                throw runtime_error("Unable to rebuild the frontier search plan");
+            targetDepth--;
+        }
+    }
+
+    result.plan.assign(reversedPlan.rbegin(), reversedPlan.rend());
+    result.status = SEARCH_SOLVED;
+    return result;
+}
@@ -0,0 +1,159 @@
+#include "planner/incremental_search.h"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+IncrementalSearch::IncrementalSearch(const TaskView &task, const SearchOptions &options)
+    : task(task), options(options), space(task, this->options)
+{
+    if (!parseTieBreaking(options.tie_breaking, tieBreaking))
+        throw runtime_error("Unknown tie-breaking policy " + options.tie_breaking);
+}
+
+// The stored value of a state, evaluating the heuristic on first sight
+IncrementalSearch::StateValue &IncrementalSearch::value(const PackedState &state)
+{
+    auto found = values.find(state);
+    if (found != values.end())
+        return found->second;
+    StateValue &entry = values[state];
+    if (space.is_goal(state)) {
+        entry.h = 0;
+        entry.exact = true;
+        solvedStates++;
+    } else {
+        PROFILE_SCOPE("heuristic");
+        entry.h = space.heuristic(state);
+    }
+    return entry;
+}
+
+// g + h capped below INFINITE_COST, so that a large learned h cannot wrap f
+static uint32_t boundedSum(uint32_t g, uint32_t h)
+{
+    return uint64_t(g) + h >= INFINITE_COST ? INFINITE_COST - 1 : g + h;
+}
+
+IncrementalResult IncrementalSearch::plan(const PackedState &start)
+{
+    IncrementalResult result;
+
+    BucketOpenList<Node> openList(tieBreaking, options.tie_breaking_seed);
+    unordered_map<PackedState, StateRecord<Node>, PackedStateHasher> records;
+    vector<unique_ptr<Node>> nodes;
+    vector<Node *> expanded;
+
+    nodes.emplace_back(new Node{start, 0, value(start).h, 0, nullptr, -1});
+    Node *root = nodes.back().get();
+    root->f = root->h;
+    if (root->h != INFINITE_COST) {
+        openList.push(root);
+        records[start].g = 0;
+        records[start].node = root;
+    }
+
+    unique_ptr<ProgressReporter> progress;
+    if (options.progress_format != "off")
+        progress.reset(new ProgressReporter(options.progress_format, options.progress_interval_ms));
+    SearchGuard guard(options);
+
+    vector<uint32_t> applicable;
+    PackedState neighbor;
+    Node *joint = nullptr;
+    while (!openList.empty()) {
+        if (guard.exceeded(result.states_expanded, result.status)) {
+            result.f_bound = openList.min_f();
+            return result;
+        }
+
+        Node *current = openList.top();
+        openList.pop();
+        StateRecord<Node> &record = records[current->state];
+        if (record.node != current)
+            continue;
+        record.closed = true;
+
+        // A state with an exact distance ends the search, goals included
+        if (values[current->state].exact) {
+            joint = current;
+            break;
+        }
+        expanded.push_back(current);
+        result.states_expanded++;
+        PROFILE_COUNT("expansions", 1);
+        if (progress)
+            progress->tick(result.states_expanded, result.states_generated, openList.size(), expanded.size(),
+                           current->f, current->h);
+
+        space.applicable_actions(current->state, applicable);
+        for (uint32_t a : applicable) {
+            space.apply(current->state, a, neighbor);
+            result.states_generated++;
+            uint32_t g = current->g + space.action_cost(a);
+            StateRecord<Node> &next = records[neighbor];
+            if (next.closed || g >= next.g)
+                continue;
+            uint32_t h = next.node ? next.node->h : value(neighbor).h;
+            next.g = g;
+            if (h == INFINITE_COST)
+                continue;
+            nodes.emplace_back(new Node{neighbor, g, h, boundedSum(g, h), current, (int32_t)a});
+            next.node = nodes.back().get();
+            openList.push(next.node);
+        }
+    }
+
+    if (!joint) {
+        // Every state reachable from the start was expanded: none reaches the goal
+        for (Node *node : expanded)
+            values[node->state].h = INFINITE_COST;
+        result.status = SEARCH_UNSOLVABLE;
+        result.f_bound = numeric_limits<float>::infinity();
+        result.known_states = values.size();
+        result.solved_states = solvedStates;
+        return result;
+    }
+
+    const uint32_t cost = joint->g + values[joint->state].h;
+    result.status = SEARCH_SOLVED;
+    result.cost = cost;
+    result.f_bound = cost;
+    result.joined = values[joint->state].next >= 0;
+
+    // Learn: cost - g is a lower bound on the distance of every expanded state.
+    // An inconsistent heuristic (hadd) can expand states with g above the cost;
+    // they learn nothing.
+    for (Node *node : expanded) {
+        StateValue &entry = values[node->state];
+        if (node->g < cost)
+            entry.h = max(entry.h, cost - node->g);
+    }
+
+    // The new path up to the joint is optimal, so its states get exact distances
+    for (Node *node = joint; node->parent != nullptr; node = node->parent) {
+        StateValue &entry = values[node->parent->state];
+        if (!entry.exact)
+            solvedStates++;
+        entry.h = cost - node->parent->g;
+        entry.exact = true;
+        entry.next = node->action;
+        result.plan.push_back(node->action);
+    }
+    reverse(result.plan.begin(), result.plan.end());
+
+    // and from the joint on the stored plan leads to the goal
+    PackedState state = joint->state;
+    for (int32_t a = values[state].next; a >= 0; a = values[state].next) {
+        result.plan.push_back(a);
+        space.apply(state, a, neighbor);
+        state.swap(neighbor);
+    }
+
+    result.known_states = values.size();
+    result.solved_states = solvedStates;
+    return result;
+}
@@ -0,0 +1,379 @@
+#include "planner/invariants.h"
+#include "planner/symmetry.h"
+
+#include <algorithm>
+#include <map>
+
+using namespace std;
+
+// One predicate of a candidate and the argument position shared by its group,
+// -1 if the whole predicate forms one group
+struct AtomPattern
+{
+    string predicate;
+    int position;
+};
+
+static bool hasFact(const uint64_t *bits, uint32_t f)
+{
+    return (bits[f / 64] >> (f % 64)) & 1;
+}
+
+static vector<uint32_t> factsOf(const TaskView &task, const uint64_t *mask)
+{
+    vector<uint32_t> facts;
+    for (uint32_t w = 0; w < task.state_words(); w++) {
+        for (uint64_t bits = mask[w]; bits; bits &= bits - 1)
+            facts.push_back(w * 64 + __builtin_ctzll(bits));
+    }
+    return facts;
+}
+
+// Split the facts matched by a candidate into groups and keep the groups that
+// are invariants
+static void checkCandidate(const TaskView &task, const vector<AtomPattern> &candidate,
+                           const vector<string> &predicates, const vector<vector<string>> &args,
+                           const map<string, size_t> &arity, const vector<bool> &changing, const vector<bool> &live,
+                           vector<MutexGroup> &found)
+{
+    map<string, uint32_t> groupIds;
+    vector<MutexGroup> groups;
+    vector<string> keys;
+    vector<vector<bool>> matched; // group -> candidate patterns with facts in the group
+    vector<int32_t> groupOf(task.num_facts(), -1);
+    for (uint32_t f = 0; f < task.num_facts(); f++) {
+        if (!changing[f])
+            continue;
+        for (size_t i = 0; i < candidate.size(); i++) {
+            const AtomPattern &pattern = candidate[i];
+            if (predicates[f] != pattern.predicate || pattern.position >= (int)args[f].size())
+                continue;
+            string key = pattern.position < 0 ? "" : args[f][pattern.position];
+            auto inserted = groupIds.emplace(key, groups.size());
+            if (inserted.second) {
+                groups.push_back(MutexGroup());
+                keys.push_back(key);
+                matched.push_back(vector<bool>(candidate.size(), false));
+            }
+            groupOf[f] = inserted.first->second;
+            groups[groupOf[f]].facts.push_back(f);
+            matched[groupOf[f]][i] = true;
+            break;
+        }
+    }
+    if (groups.empty())
+        return;
+
+    // Name a group by its patterns with the shared argument filled in
+    for (size_t g = 0; g < groups.size(); g++) {
+        for (size_t i = 0; i < candidate.size(); i++) {
+            if (!matched[g][i])
+                continue;
+            string &name = groups[g].name;
+            name += (name.empty() ? "" : " ") + candidate[i].predicate + "(";
+            for (int p = 0; p < (int)arity.at(candidate[i].predicate); p++)
+                name += (p ? "," : "") + (p == candidate[i].position ? keys[g] : string("*"));
+            name += ")";
+        }
+    }
+
+    vector<bool> valid(groups.size(), true);
+    vector<uint32_t> initialCount(groups.size(), 0);
+    for (uint32_t f = 0; f < task.num_facts(); f++) {
+        if (groupOf[f] >= 0 && hasFact(task.initial, f) && ++initialCount[groupOf[f]] > 1)
+            valid[groupOf[f]] = false;
+    }
+
+    for (uint32_t a = 0; a < task.num_actions(); a++) {
+        if (!live[a])
+            continue;
+        vector<uint32_t> added = factsOf(task, task.mask(a, MASK_ADD));
+        vector<uint32_t> required = factsOf(task, task.mask(a, MASK_PRE_POS));
+        for (uint32_t f : added) {
+            int32_t g = groupOf[f];
+            if (g < 0 || !valid[g])
+                continue;
+
+            uint32_t requiredInGroup = 0, addedInGroup = 0;
+            bool alreadyTrue = false, consumes = false;
+            for (uint32_t p : required) {
+                if (groupOf[p] != g)
+                    continue;
+                requiredInGroup++;
+                alreadyTrue |= p == f;
+                // A precondition that is deleted and not added back
+                consumes |= hasFact(task.mask(a, MASK_DEL), p) && !hasFact(task.mask(a, MASK_ADD), p);
+            }
+            for (uint32_t other : added)
+                addedInGroup += groupOf[other] == g;
+
+            if (requiredInGroup >= 2)
+                continue; // never applies while the group holds
+            if (addedInGroup >= 2 || (!alreadyTrue && !consumes))
+                valid[g] = false;
+        }
+    }
+
+    for (size_t g = 0; g < groups.size(); g++) {
+        if (valid[g] && groups[g].facts.size() >= 2)
+            found.push_back(groups[g]);
+    }
+}
+
+InvariantAnalysis analyzeInvariants(const TaskView &task)
+{
+    PROFILE_SCOPE("invariants");
+    InvariantAnalysis analysis;
+    const uint32_t words = task.state_words();
+    PackedState initial = task.initial_state();
+
+    // Relaxed exploration: facts no action sequence can reach are as good as
+    // static and false, and actions needing them never apply
+    PackedState reached = initial;
+    vector<bool> live(task.num_actions(), false);
+    for (bool grew = true; grew;) {
+        grew = false;
+        for (uint32_t a = 0; a < task.num_actions(); a++) {
+            if (live[a] || !isApplicableEDL(task, reached, a))
+                continue;
+            live[a] = true;
+            grew = true;
+            for (uint32_t w = 0; w < words; w++)
+                reached[w] |= task.mask(a, MASK_ADD)[w];
+        }
+    }
+
+    // Static facts are never added or deleted; their initial value is final
+    PackedState changed(words, 0);
+    for (uint32_t a = 0; a < task.num_actions(); a++) {
+        if (!live[a])
+            continue;
+        for (uint32_t w = 0; w < words; w++)
+            changed[w] |= task.mask(a, MASK_ADD)[w] | task.mask(a, MASK_DEL)[w];
+    }
+    vector<bool> changing(task.num_facts());
+    for (uint32_t f = 0; f < task.num_facts(); f++)
+        changing[f] = testFact(changed, f);
+
+    for (uint32_t a = 0; a < task.num_actions(); a++) {
+        for (uint32_t w = 0; w < words; w++) {
+            uint64_t staticTrue = ~changed[w] & initial[w];
+            if (task.mask(a, MASK_PRE_NEG)[w] & staticTrue)
+                live[a] = false;
+        }
+    }
+
+    // Candidates: every predicate and argument position of the changing facts,
+    // alone and joined pairwise
+    vector<string> predicates(task.num_facts());
+    vector<vector<string>> args(task.num_facts());
+    map<string, size_t> arity;
+    for (uint32_t f = 0; f < task.num_facts(); f++) {
+        parseAtomName(task.fact_name(f), predicates[f], args[f]);
+        if (changing[f])
+            arity[predicates[f]] = args[f].size();
+    }
+    vector<AtomPattern> patterns;
+    for (const auto &entry : arity) {
+        patterns.push_back(AtomPattern{entry.first, -1});
+        for (size_t i = 0; i < entry.second; i++)
+            patterns.push_back(AtomPattern{entry.first, (int)i});
+    }
+
+    vector<MutexGroup> found;
+    for (size_t i = 0; i < patterns.size(); i++) {
+        checkCandidate(task, {patterns[i]}, predicates, args, arity, changing, live, found);
+        for (size_t j = i + 1; j < patterns.size(); j++) {
+            bool sameKind = (patterns[i].position < 0) == (patterns[j].position < 0);
+            if (patterns[i].predicate != patterns[j].predicate && sameKind)
+                checkCandidate(task, {patterns[i], patterns[j]}, predicates, args, arity, changing, live, found);
+        }
+    }
+
+    // Keep the maximal groups only
+    for (MutexGroup &group : found)
+        sort(group.facts.begin(), group.facts.end());
+    sort(found.begin(), found.end(), [](const MutexGroup &a, const MutexGroup &b) {
+        return a.facts.size() != b.facts.size() ? a.facts.size() > b.facts.size() : a.facts < b.facts;
+    });
+    for (const MutexGroup &group : found) {
+        bool covered = false;
+        for (const MutexGroup &kept : analysis.groups) {
+            if (includes(kept.facts.begin(), kept.facts.end(), group.facts.begin(), group.facts.end())) {
+                covered = true;
+                break;
+            }
+        }
+        if (!covered)
+            analysis.groups.push_back(group);
+    }
+
+    // Actions needing two facts of one group never apply
+    vector<vector<uint32_t>> groupsOf(task.num_facts());
+    for (uint32_t g = 0; g < analysis.groups.size(); g++) {
+        for (uint32_t f : analysis.groups[g].facts)
+            groupsOf[f].push_back(g);
+    }
+    auto needsMutexFacts = [&](const vector<uint32_t> &facts) {
+        vector<uint32_t> seen;
+        for (uint32_t f : facts) {
+            for (uint32_t g : groupsOf[f]) {
+                if (find(seen.begin(), seen.end(), g) != seen.end())
+                    return true;
+                seen.push_back(g);
+            }
+        }
+        return false;
+    };
+    analysis.reachable_action = live;
+    for (uint32_t a = 0; a < task.num_actions(); a++) {
+        if (live[a] && needsMutexFacts(factsOf(task, task.mask(a, MASK_PRE_POS))))
+            analysis.reachable_action[a] = false;
+        if (!analysis.reachable_action[a])
+            analysis.pruned_actions++;
+    }
+
+    for (uint32_t w = 0; w < words; w++) {
+        if ((task.goal_pos[w] & ~reached[w]) || (task.goal_neg[w] & ~changed[w] & initial[w]))
+            analysis.goal_unreachable = true;
+    }
+    if (needsMutexFacts(factsOf(task, task.goal_pos)))
+        analysis.goal_unreachable = true;
+    return analysis;
+}
+
+FiniteDomainEncoding::FiniteDomainEncoding(const TaskView &task, const vector<MutexGroup> &groups)
+    : factVariable(task.num_facts(), -1), factValue(task.num_facts(), 0), staticFacts(task.initial_state())
+{
+    PackedState changed(task.state_words(), 0);
+    for (uint32_t a = 0; a < task.num_actions(); a++) {
+        for (uint32_t w = 0; w < task.state_words(); w++)
+            changed[w] |= task.mask(a, MASK_ADD)[w] | task.mask(a, MASK_DEL)[w];
+    }
+    for (uint32_t w = 0; w < task.state_words(); w++)
+        staticFacts[w] &= ~changed[w];
+
+    // Largest groups first, each fact in one variable
+    vector<const MutexGroup *> order;
+    for (const MutexGroup &group : groups)
+        order.push_back(&group);
+    stable_sort(order.begin(), order.end(),
+                [](const MutexGroup *a, const MutexGroup *b) { return a->facts.size() > b->facts.size(); });
+    vector<bool> assigned(task.num_facts(), false);
+    auto addVariable = [&](const vector<uint32_t> &facts) {
+        Variable variable;
+        variable.facts = facts;
+        variable.bits = 32 - __builtin_clz((uint32_t)facts.size());
+        variable.offset = numBits;
+        if (variable.offset / 64 != (variable.offset + variable.bits - 1) / 64)
+            variable.offset = (variable.offset / 64 + 1) * 64;
+        numBits = variable.offset + variable.bits;
+        for (uint32_t v = 0; v < facts.size(); v++) {
+            factVariable[facts[v]] = variables.size();
+            factValue[facts[v]] = v + 1;
+            assigned[facts[v]] = true;
+        }
+        variables.push_back(variable);
+    };
+    for (const MutexGroup *group : order) {
+        vector<uint32_t> facts;
+        for (uint32_t f : group->facts) {
+            if (!assigned[f] && testFact(changed, f))
+                facts.push_back(f);
+        }
+        if (facts.size() >= 2)
+            addVariable(facts);
+    }
+    for (uint32_t f = 0; f < task.num_facts(); f++) {
+        if (!assigned[f] && testFact(changed, f))
+            addVariable({f});
+    }
+    numWords = max<uint32_t>(1, (numBits + 63) / 64);
+}
+
+void FiniteDomainEncoding::encode(const PackedState &state, PackedState &packed) const
+{
+    packed.assign(numWords, 0);
+    for (uint32_t w = 0; w < state.size(); w++) {
+        for (uint64_t bits = state[w]; bits; bits &= bits - 1) {
+            uint32_t f = w * 64 + __builtin_ctzll(bits);
+            if (factVariable[f] < 0)
+                continue;
+            const Variable &variable = variables[factVariable[f]];
+            packed[variable.offset / 64] |= uint64_t(factValue[f]) << (variable.offset % 64);
+        }
+    }
+}
+
+void FiniteDomainEncoding::decode(const PackedState &packed, PackedState &state) const
+{
+    state = staticFacts;
+    for (const Variable &variable : variables) {
+        uint64_t value = (packed[variable.offset / 64] >> (variable.offset % 64)) & ((uint64_t(1) << variable.bits) - 1);
+        if (value) {
+            uint32_t f = variable.facts[value - 1];
+            state[f / 64] |= uint64_t(1) << (f % 64);
+        }
+    }
+}
+
+// Search space over encoded states. The last expanded state and the last
+// successor are kept decoded, which covers the calls A* makes in a row.
+class CompactSpace
+{
+    GroundedSpace inner;
+    const FiniteDomainEncoding &encoding;
+    PackedState parentKey, parent;
+    PackedState successorKey, successor;
+
+    const PackedState &unpack(const PackedState &state)
+    {
+        if (state == successorKey)
+            return successor;
+        if (state != parentKey) {
+            parentKey = state;
+            encoding.decode(state, parent);
+        }
+        return parent;
+    }
+
+public:
+    typedef PackedState State;
+    typedef PackedStateHasher StateHasher;
+
+    CompactSpace(const TaskView &task, const FiniteDomainEncoding &encoding, const SearchOptions &options,
+                 StubbornSets *stubbornSets)
+        : inner(task, options), encoding(encoding)
+    {
+        inner.stubborn_sets = stubbornSets;
+    }
+
+    State initial_state()
+    {
+        State state;
+        encoding.encode(inner.initial_state(), state);
+        return state;
+    }
+    bool is_goal(const State &state) { return inner.is_goal(unpack(state)); }
+    void applicable_actions(const State &state, vector<uint32_t> &actions)
+    {
+        inner.applicable_actions(unpack(state), actions);
+    }
+    void apply(const State &state, uint32_t action, State &result)
+    {
+        PackedState next;
+        inner.apply(unpack(state), action, next);
+        successor.swap(next);
+        encoding.encode(successor, result);
+        successorKey = result;
+    }
+    uint32_t action_cost(uint32_t action) const { return inner.action_cost(action); }
+    uint32_t heuristic(const State &state) { return inner.heuristic(unpack(state)); }
+};
+
+SearchResult compactAstar(const TaskView &task, const FiniteDomainEncoding &encoding, const SearchOptions &options,
+                          StubbornSets *stubbornSets)
+{
+    CompactSpace space(task, encoding, options, stubbornSets);
+    return astarSearch(space, options);
+}
@@ -0,0 +1,442 @@
+#include "planner/lifted.h"
+
+#include <algorithm>
+#include <list>
+#include <stdexcept>
+#include <unordered_map>
+
+using namespace std;
+
+typedef vector<uint32_t> LiftedState;
+
+struct LiftedStateHasher
+{
+    size_t operator()(const vector<uint32_t> &values) const
+    {
+        size_t seed = values.size();
+        for (uint32_t v : values) {
+            seed ^= hash<uint32_t>{}(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        }
+        return seed;
+    }
+};
+
+// A schema atom; term t >= 0 is parameter t, t < 0 is the constant symbol ~t
+struct LiftedAtom
+{
+    uint32_t predicate;
+    vector<int> terms;
+};
+
+struct LiftedSchema
+{
+    string name;
+    uint32_t num_params;
+    vector<LiftedAtom> pre_pos;
+    vector<LiftedAtom> pre_neg;
+    vector<LiftedAtom> add;
+    vector<LiftedAtom> del;
+    uint32_t cost;
+};
+
+class LiftedSpace
+{
+    vector<string> symbols; // the first num_objects are the Env symbols, then schema constants
+    uint32_t num_objects = 0;
+    unordered_map<string, uint32_t> symbolIds;
+    vector<string> predicates;
+    unordered_map<string, uint32_t> predicateIds;
+    vector<LiftedSchema> schemas;
+
+    // Fact table: fact id -> {predicate, args...}
+    vector<vector<uint32_t>> facts;
+    unordered_map<vector<uint32_t>, uint32_t, LiftedStateHasher> factIds;
+
+    // Grounding table: grounding id -> {schema, args...}
+    vector<vector<uint32_t>> groundings;
+    unordered_map<vector<uint32_t>, uint32_t, LiftedStateHasher> groundingIds;
+
+    LiftedState initial;
+    vector<uint32_t> goal;
+    uint32_t max_effect_size = 0;
+    uint32_t min_action_cost = UINT32_MAX;
+
+    const SearchOptions &options;
+
+    // Per-state join indices, rebuilt by indexState()
+    vector<vector<uint32_t>> factsByPredicate;
+    unordered_map<uint64_t, vector<uint32_t>> factsByArgument;
+
+    uint32_t symbolId(const string &name)
+    {
+        auto it = symbolIds.find(name);
+        if (it != symbolIds.end())
+            return it->second;
+        symbols.push_back(name);
+        return symbolIds[name] = symbols.size() - 1;
+    }
+
+    uint32_t predicateId(const string &name)
+    {
+        auto it = predicateIds.find(name);
+        if (it != predicateIds.end())
+            return it->second;
+        predicates.push_back(name);
+        return predicateIds[name] = predicates.size() - 1;
+    }
+
+    uint32_t internFact(const vector<uint32_t> &atom)
+    {
+        auto it = factIds.find(atom);
+        if (it != factIds.end())
+            return it->second;
+        facts.push_back(atom);
+        return factIds[atom] = facts.size() - 1;
+    }
+
+    // Fact id of a ground atom, or -1 if it was never interned (and so is false everywhere)
+    int64_t findFact(const vector<uint32_t> &atom) const
+    {
+        auto it = factIds.find(atom);
+        return it == factIds.end() ? -1 : (int64_t)it->second;
+    }
+
+    static uint64_t argumentKey(uint32_t predicate, uint32_t position, uint32_t symbol)
+    {
+        return (uint64_t(predicate) << 40) | (uint64_t(position) << 32) | symbol;
+    }
+
+    LiftedAtom liftAtom(const Condition &cond, const vector<string> &params)
+    {
+        LiftedAtom atom;
+        atom.predicate = predicateId(cond.get_predicate());
+        for (const string &arg : cond.get_args()) {
+            auto it = find(params.begin(), params.end(), arg);
+            if (it != params.end())
+                atom.terms.push_back(distance(params.begin(), it));
+            else
+                atom.terms.push_back(~(int)symbolId(arg));
+        }
+        return atom;
+    }
+
+    vector<uint32_t> groundAtom(const LiftedAtom &atom, const vector<int64_t> &binding) const
+    {
+        vector<uint32_t> ground;
+        ground.reserve(atom.terms.size() + 1);
+        ground.push_back(atom.predicate);
+        for (int t : atom.terms)
+            ground.push_back(t >= 0 ? binding[t] : ~t);
+        return ground;
+    }
+
+    static bool holds(const LiftedState &state, uint32_t fact)
+    {
+        return binary_search(state.begin(), state.end(), fact);
+    }
+
+    void indexState(const LiftedState &state)
+    {
+        factsByPredicate.assign(predicates.size(), vector<uint32_t>());
+        factsByArgument.clear();
+        for (uint32_t f : state) {
+            const vector<uint32_t> &atom = facts[f];
+            factsByPredicate[atom[0]].push_back(f);
+            for (uint32_t pos = 1; pos < atom.size(); pos++)
+                factsByArgument[argumentKey(atom[0], pos - 1, atom[pos])].push_back(f);
+        }
+    }
+
+    // Candidate facts for a schema atom under a partial binding: the smallest
+    // index list over its bound arguments, or every fact of its predicate
+    const vector<uint32_t> &candidates(const LiftedAtom &atom, const vector<int64_t> &binding) const
+    {
+        static const vector<uint32_t> none;
+        const vector<uint32_t> *best = &factsByPredicate[atom.predicate];
+        for (uint32_t pos = 0; pos < atom.terms.size(); pos++) {
+            int t = atom.terms[pos];
+            int64_t value = t >= 0 ? binding[t] : ~t;
+            if (value < 0)
+                continue;
+            auto it = factsByArgument.find(argumentKey(atom.predicate, pos, value));
+            if (it == factsByArgument.end())
+                return none;
+            if (it->second.size() < best->size())
+                best = &it->second;
+        }
+        return *best;
+    }
+
+    // Greedy join order: start from the atom with the fewest matching facts, then
+    // keep taking the atom with the most bound terms (ties: fewest facts)
+    vector<uint32_t> joinOrder(const LiftedSchema &schema) const
+    {
+        vector<uint32_t> order;
+        vector<bool> used(schema.pre_pos.size(), false);
+        vector<bool> bound(schema.num_params, false);
+        for (size_t step = 0; step < schema.pre_pos.size(); step++) {
+            int best = -1;
+            size_t bestBound = 0, bestSize = 0;
+            for (size_t i = 0; i < schema.pre_pos.size(); i++) {
+                if (used[i])
+                    continue;
+                const LiftedAtom &atom = schema.pre_pos[i];
+                size_t numBound = 0;
+                for (int t : atom.terms)
+                    if (t < 0 || bound[t])
+                        numBound++;
+                size_t size = factsByPredicate[atom.predicate].size();
+                if (best < 0 || numBound > bestBound || (numBound == bestBound && size < bestSize)) {
+                    best = i;
+                    bestBound = numBound;
+                    bestSize = size;
+                }
+            }
+            used[best] = true;
+            order.push_back(best);
+            for (int t : schema.pre_pos[best].terms)
+                if (t >= 0)
+                    bound[t] = true;
+        }
+        return order;
+    }
+
+    void emitGrounding(uint32_t schemaId, const vector<int64_t> &binding, const LiftedState &state,
+                       bool relaxed, vector<uint32_t> &actions)
+    {
+        const LiftedSchema &schema = schemas[schemaId];
+        if (!relaxed) {
+            for (const LiftedAtom &atom : schema.pre_neg) {
+                int64_t f = findFact(groundAtom(atom, binding));
+                if (f >= 0 && holds(state, f))
+                    return;
+            }
+        }
+        vector<uint32_t> key(1, schemaId);
+        for (int64_t value : binding)
+            key.push_back(value);
+        auto it = groundingIds.find(key);
+        if (it == groundingIds.end()) {
+            groundings.push_back(key);
+            it = groundingIds.emplace(key, groundings.size() - 1).first;
+        }
+        actions.push_back(it->second);
+    }
+
+    // Parameters that no positive precondition binds range over all unused objects,
+    // as in generateGroundedCombinations every parameter takes a distinct symbol
+    void bindFreeParams(uint32_t schemaId, vector<int64_t> &binding, vector<bool> &usedSymbols, uint32_t param,
+                        const LiftedState &state, bool relaxed, vector<uint32_t> &actions)
+    {
+        const LiftedSchema &schema = schemas[schemaId];
+        while (param < schema.num_params && binding[param] >= 0)
+            param++;
+        if (param == schema.num_params) {
+            emitGrounding(schemaId, binding, state, relaxed, actions);
+            return;
+        }
+        for (uint32_t s = 0; s < num_objects; s++) {
+            if (usedSymbols[s])
+                continue;
+            binding[param] = s;
+            usedSymbols[s] = true;
+            bindFreeParams(schemaId, binding, usedSymbols, param + 1, state, relaxed, actions);
+            usedSymbols[s] = false;
+        }
+        binding[param] = -1;
+    }
+
+    void join(uint32_t schemaId, const vector<uint32_t> &order, size_t depth, vector<int64_t> &binding,
+              vector<bool> &usedSymbols, const LiftedState &state, bool relaxed, vector<uint32_t> &actions)
+    {
+        const LiftedSchema &schema = schemas[schemaId];
+        if (depth == order.size()) {
+            bindFreeParams(schemaId, binding, usedSymbols, 0, state, relaxed, actions);
+            return;
+        }
+
+        const LiftedAtom &atom = schema.pre_pos[order[depth]];
+        for (uint32_t f : candidates(atom, binding)) {
+            const vector<uint32_t> &fact = facts[f];
+            if (fact.size() != atom.terms.size() + 1)
+                continue;
+
+            // Unify the atom with the fact, remembering which parameters this level bound
+            vector<uint32_t> newlyBound;
+            bool match = true;
+            for (uint32_t pos = 0; pos < atom.terms.size() && match; pos++) {
+                int t = atom.terms[pos];
+                uint32_t value = fact[pos + 1];
+                if (t < 0) {
+                    match = (uint32_t)~t == value;
+                } else if (binding[t] >= 0) {
+                    match = binding[t] == value;
+                } else if (value >= num_objects || usedSymbols[value]) {
+                    match = false;
+                } else {
+                    binding[t] = value;
+                    usedSymbols[value] = true;
+                    newlyBound.push_back(t);
+                }
+            }
+            if (match)
+                join(schemaId, order, depth + 1, binding, usedSymbols, state, relaxed, actions);
+            for (uint32_t t : newlyBound) {
+                usedSymbols[binding[t]] = false;
+                binding[t] = -1;
+            }
+        }
+    }
+
+    void collectApplicable(const LiftedState &state, bool relaxed, vector<uint32_t> &actions)
+    {
+        actions.clear();
+        indexState(state);
+        for (uint32_t s = 0; s < schemas.size(); s++) {
+            vector<int64_t> binding(schemas[s].num_params, -1);
+            vector<bool> usedSymbols(symbols.size(), false);
+            join(s, joinOrder(schemas[s]), 0, binding, usedSymbols, state, relaxed, actions);
+        }
+    }
+
+    void applyGrounding(const LiftedState &state, uint32_t action, bool relaxed, LiftedState &result)
+    {
+        const vector<uint32_t> &key = groundings[action];
+        const LiftedSchema &schema = schemas[key[0]];
+        vector<int64_t> binding(key.begin() + 1, key.end());
+
+        result = state;
+        if (!relaxed) {
+            for (const LiftedAtom &atom : schema.del) {
+                int64_t f = findFact(groundAtom(atom, binding));
+                if (f >= 0) {
+                    auto it = lower_bound(result.begin(), result.end(), (uint32_t)f);
+                    if (it != result.end() && *it == f)
+                        result.erase(it);
+                }
+            }
+        }
+        for (const LiftedAtom &atom : schema.add) {
+            uint32_t f = internFact(groundAtom(atom, binding));
+            auto it = lower_bound(result.begin(), result.end(), f);
+            if (it == result.end() || *it != f)
+                result.insert(it, f);
+        }
+    }
+
+    uint32_t internGroundedCondition(const GroundedCondition &gc)
+    {
+        vector<uint32_t> atom(1, predicateId(gc.get_predicate()));
+        for (const string &arg : gc.get_arg_values())
+            atom.push_back(symbolId(arg));
+        return internFact(atom);
+    }
+
+public:
+    typedef LiftedState State;
+    typedef LiftedStateHasher StateHasher;
+
+    LiftedSpace(const Env &env, const SearchOptions &options) : options(options)
+    {
+        vector<string> envSymbols;
+        for (const string &s : env.get_symbols())
+            envSymbols.push_back(s);
+        sort(envSymbols.begin(), envSymbols.end());
+        for (const string &s : envSymbols)
+            symbolId(s);
+        num_objects = symbols.size();
+
+        for (const Action &action : env.get_actions()) {
+            LiftedSchema schema;
+            schema.name = action.get_name();
+            list<string> paramList = action.get_args();
+            vector<string> params(paramList.begin(), paramList.end());
+            schema.num_params = params.size();
+            for (const Condition &cond : action.get_preconditions())
+                (cond.get_truth() ? schema.pre_pos : schema.pre_neg).push_back(liftAtom(cond, params));
+            for (const Condition &cond : action.get_effects())
+                (cond.get_truth() ? schema.add : schema.del).push_back(liftAtom(cond, params));
+            max_effect_size = max(max_effect_size, (uint32_t)(schema.add.size() + schema.del.size()));
+            schema.cost = action.get_cost();
+            min_action_cost = min(min_action_cost, schema.cost);
+            schemas.push_back(schema);
+        }
+        sort(schemas.begin(), schemas.end(), [](const LiftedSchema &a, const LiftedSchema &b) { return a.name < b.name; });
+
+        for (const GroundedCondition &gc : env.get_initial_conditions())
+            initial.push_back(internGroundedCondition(gc));
+        sort(initial.begin(), initial.end());
+        for (const GroundedCondition &gc : env.get_goal_conditions())
+            goal.push_back(internGroundedCondition(gc));
+    }
+
+    State initial_state() const { return initial; }
+
+    bool is_goal(const State &state) const
+    {
+        for (uint32_t f : goal) {
+            if (!holds(state, f))
+                return false;
+        }
+        return true;
+    }
+
+    // Goals of an environment are all positive
+    bool is_goal_relaxed(const State &state) const { return is_goal(state); }
+
+    void applicable_actions(const State &state, vector<uint32_t> &actions) { collectApplicable(state, false, actions); }
+    void applicable_actions_relaxed(const State &state, vector<uint32_t> &actions) { collectApplicable(state, true, actions); }
+    void apply(const State &state, uint32_t action, State &result) { applyGrounding(state, action, false, result); }
+    void apply_relaxed(const State &state, uint32_t action, State &result) { applyGrounding(state, action, true, result); }
+    void state_facts(const State &state, vector<uint32_t> &stateFacts) const { stateFacts = state; }
+
+    uint32_t action_cost(uint32_t action) const { return schemas[groundings[action][0]].cost; }
+
+    uint32_t goal_count_heuristic(const State &state) const
+    {
+        if (max_effect_size <= 0) {
+            throw runtime_error("max_effect_size is less than or equal to 0");
+        }
+        uint32_t missing = 0;
+        for (uint32_t f : goal) {
+            if (!holds(state, f))
+                missing++;
+        }
+        return (missing + max_effect_size - 1) / max_effect_size * min_action_cost;
+    }
+
+    uint32_t heuristic(const State &state)
+    {
+        return getHeuristic(*this, state, options);
+    }
+
+    GroundedAction grounded_action(uint32_t action) const
+    {
+        const vector<uint32_t> &key = groundings[action];
+        list<string> args;
+        for (size_t i = 1; i < key.size(); i++)
+            args.push_back(symbols[key[i]]);
+        return GroundedAction(schemas[key[0]].name, args);
+    }
+
+    string action_name(uint32_t action) const
+    {
+        return grounded_action(action).toString();
+    }
+
+    size_t num_facts() const { return facts.size(); }
+    size_t num_groundings() const { return groundings.size(); }
+};
+
+LiftedSearchResult liftedSearch(const Env &env, const SearchOptions &options)
+{
+    LiftedSpace space(env, options);
+    LiftedSearchResult result;
+    static_cast<SearchResult &>(result) = astarSearch(space, options);
+    for (uint32_t a : result.plan) {
+        result.action_names.push_back(space.action_name(a));
+    }
+    result.facts_interned = space.num_facts();
+    result.groundings_interned = space.num_groundings();
+    return result;
+}
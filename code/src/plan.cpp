@@ -0,0 +1,170 @@
+#include "planner/plan.h"
+#include "planner/profiling.h"
+
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+
+using namespace std;
+
+template <typename Visit>
+static void forEachFact(const TaskView &task, const uint64_t *mask, Visit visit)
+{
+    for (uint32_t w = 0; w < task.state_words(); w++) {
+        for (uint64_t bits = mask[w]; bits; bits &= bits - 1)
+            visit(w * 64 + __builtin_ctzll(bits));
+    }
+}
+
+bool validatePlan(const TaskView &task, const vector<uint32_t> &plan, string &error)
+{
+    PROFILE_SCOPE("validate_plan");
+    PackedState state = task.initial_state(), next;
+    for (size_t i = 0; i < plan.size(); i++) {
+        uint32_t a = plan[i];
+        if (a >= task.num_actions()) {
+            error = "step " + to_string(i + 1) + ": no action " + to_string(a);
+            return false;
+        }
+        if (!isApplicable(task, state, a)) {
+            string failed;
+            forEachFact(task, task.mask(a, MASK_PRE_POS), [&](uint32_t f) {
+                if (failed.empty() && !testFact(state, f))
+                    failed = task.fact_name(f);
+            });
+            forEachFact(task, task.mask(a, MASK_PRE_NEG), [&](uint32_t f) {
+                if (failed.empty() && testFact(state, f))
+                    failed = "!" + task.fact_name(f);
+            });
+            error = "step " + to_string(i + 1) + " " + task.action_name(a) + ": precondition " + failed + " does not hold";
+            return false;
+        }
+        applyAction(task, state, a, next);
+        state.swap(next);
+    }
+    if (!isGoal(task, state)) {
+        string failed;
+        forEachFact(task, task.goal_pos, [&](uint32_t f) {
+            if (failed.empty() && !testFact(state, f))
+                failed = task.fact_name(f);
+        });
+        forEachFact(task, task.goal_neg, [&](uint32_t f) {
+            if (failed.empty() && testFact(state, f))
+                failed = "!" + task.fact_name(f);
+        });
+        error = "goal " + failed + " does not hold after the plan";
+        return false;
+    }
+    return true;
+}
+
+// Cut every subsequence that returns to a state seen before
+static void removeLoops(const TaskView &task, vector<uint32_t> &plan)
+{
+    vector<uint32_t> kept;
+    vector<PackedState> states(1, task.initial_state());
+    unordered_map<PackedState, size_t, PackedStateHasher> position;
+    position[states[0]] = 0;
+    PackedState next;
+    for (uint32_t a : plan) {
+        applyAction(task, states.back(), a, next);
+        auto seen = position.find(next);
+        if (seen == position.end()) {
+            kept.push_back(a);
+            states.push_back(next);
+            position[next] = kept.size();
+            continue;
+        }
+        // Back to an earlier state: forget everything after it
+        size_t back = seen->second;
+        while (kept.size() > back) {
+            position.erase(states.back());
+            states.pop_back();
+            kept.pop_back();
+        }
+    }
+    plan.swap(kept);
+}
+
+// Regress the goal through the plan; an action is kept only if it achieves a
+// literal still needed after it
+static void removeUnjustified(const TaskView &task, vector<uint32_t> &plan)
+{
+    const uint32_t words = task.state_words();
+    vector<uint64_t> needTrue(task.goal_pos, task.goal_pos + words);
+    vector<uint64_t> needFalse(task.goal_neg, task.goal_neg + words);
+    vector<bool> keep(plan.size(), false);
+    for (size_t i = plan.size(); i-- > 0;) {
+        const uint64_t *prePos = task.mask(plan[i], MASK_PRE_POS);
+        const uint64_t *preNeg = task.mask(plan[i], MASK_PRE_NEG);
+        const uint64_t *add = task.mask(plan[i], MASK_ADD);
+        const uint64_t *del = task.mask(plan[i], MASK_DEL);
+        for (uint32_t w = 0; w < words && !keep[i]; w++)
+            keep[i] = (add[w] & needTrue[w]) || (del[w] & ~add[w] & needFalse[w]);
+        if (!keep[i])
+            continue;
+        for (uint32_t w = 0; w < words; w++) {
+            needTrue[w] = (needTrue[w] & ~add[w]) | prePos[w];
+            needFalse[w] = (needFalse[w] & ~(del[w] & ~add[w])) | preNeg[w];
+        }
+    }
+
+    vector<uint32_t> kept;
+    for (size_t i = 0; i < plan.size(); i++) {
+        if (keep[i])
+            kept.push_back(plan[i]);
+    }
+    plan.swap(kept);
+}
+
+size_t removeRedundantActions(const TaskView &task, vector<uint32_t> &plan)
+{
+    PROFILE_SCOPE("remove_redundant_actions");
+    size_t before = plan.size();
+    removeLoops(task, plan);
+
+    // Justification is sound for valid plans; the check guards the assumption
+    vector<uint32_t> justified = plan;
+    removeUnjustified(task, justified);
+    string error;
+    if (justified.size() < plan.size() && validatePlan(task, justified, error))
+        plan.swap(justified);
+    return before - plan.size();
+}
+
+size_t reorderForMakespan(const TaskView &task, vector<uint32_t> &plan)
+{
+    PROFILE_SCOPE("reorder_plan");
+    // Layer of the last action writing and the last action reading each fact; 0 is the initial state
+    vector<uint32_t> lastWrite(task.num_facts(), 0), lastRead(task.num_facts(), 0);
+    vector<uint32_t> layer(plan.size());
+    size_t makespan = 0;
+    for (size_t i = 0; i < plan.size(); i++) {
+        uint32_t a = plan[i];
+        uint32_t earliest = 1;
+        auto afterWrites = [&](uint32_t f) { earliest = max(earliest, lastWrite[f] + 1); };
+        auto afterAccess = [&](uint32_t f) { earliest = max(earliest, max(lastWrite[f], lastRead[f]) + 1); };
+        forEachFact(task, task.mask(a, MASK_PRE_POS), afterWrites);
+        forEachFact(task, task.mask(a, MASK_PRE_NEG), afterWrites);
+        forEachFact(task, task.mask(a, MASK_ADD), afterAccess);
+        forEachFact(task, task.mask(a, MASK_DEL), afterAccess);
+
+        layer[i] = earliest;
+        auto read = [&](uint32_t f) { lastRead[f] = max(lastRead[f], earliest); };
+        auto write = [&](uint32_t f) { lastWrite[f] = earliest; };
+        forEachFact(task, task.mask(a, MASK_PRE_POS), read);
+        forEachFact(task, task.mask(a, MASK_PRE_NEG), read);
+        forEachFact(task, task.mask(a, MASK_ADD), write);
+        forEachFact(task, task.mask(a, MASK_DEL), write);
+        makespan = max<size_t>(makespan, earliest);
+    }
+
+    vector<size_t> order(plan.size());
+    iota(order.begin(), order.end(), 0);
+    stable_sort(order.begin(), order.end(), [&](size_t x, size_t y) { return layer[x] < layer[y]; });
+    vector<uint32_t> reordered;
+    for (size_t i : order)
+        reordered.push_back(plan[i]);
+    plan.swap(reordered);
+    return makespan;
+}
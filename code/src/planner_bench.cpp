@@ -0,0 +1,529 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <csignal>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <sys/types.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Benchmark driver for the planner. It writes scaled instances of the domains in
+// envs/ with seeded generators, runs the planner binary on every instance and
+// configuration with repetitions, and reports median wall time, expansions per
+// second, peak RSS and plan cost as CSV or JSON. Every run is a separate process
+// so that peak RSS belongs to that run alone.
+
+#ifndef PLANNER_PATH
+#define PLANNER_PATH "./planner"
+#endif
+
+using namespace std;
+
+/////////////// Instance generators ///////////////
+
+struct Instance
+{
+    string domain;
+    string name;
+    string text;
+};
+
+static string joinFacts(const vector<string> &facts)
+{
+    string joined;
+    for (size_t i = 0; i < facts.size(); i++) {
+        if (i > 0)
+            joined += ", ";
+        joined += facts[i];
+    }
+    return joined;
+}
+
+// Random towers: every item is placed on the table or on top of an earlier tower
+static vector<vector<string>> randomTowers(vector<string> items, mt19937 &rng)
+{
+    shuffle(items.begin(), items.end(), rng);
+    vector<vector<string>> towers;
+    for (const string &item : items) {
+        uniform_int_distribution<size_t> pick(0, towers.size());
+        size_t t = pick(rng);
+        if (t == towers.size())
+            towers.push_back(vector<string>());
+        towers[t].push_back(item);
+    }
+    return towers;
+}
+
+static void towerFacts(const vector<vector<string>> &towers, vector<string> &facts, bool withClear)
+{
+    for (const auto &tower : towers) {
+        for (size_t i = 0; i < tower.size(); i++)
+            facts.push_back("On(" + tower[i] + "," + (i == 0 ? string("Table") : tower[i - 1]) + ")");
+        if (withClear)
+            facts.push_back("Clear(" + tower.back() + ")");
+    }
+}
+
+Instance generateBlocks(int blocks, unsigned seed)
+{
+    mt19937 rng(seed);
+    vector<string> names;
+    for (int i = 0; i < blocks; i++)
+        names.push_back("B" + to_string(i));
+
+    vector<string> initial, goal;
+    towerFacts(randomTowers(names, rng), initial, true);
+    for (const string &b : names)
+        initial.push_back("Block(" + b + ")");
+    towerFacts(randomTowers(names, rng), goal, false);
+
+    string text = "Symbols: " + joinFacts(names) + ", Table\n";
+    text += "Initial conditions: " + joinFacts(initial) + "\n";
+    text += "Goal conditions: " + joinFacts(goal) + "\n\n";
+    text += "Actions:\n"
+            "        MoveToTable(b,x)\n"
+            "        Preconditions: On(b,x), Clear(b), Block(b), Block(x)\n"
+            "        Effects: On(b,Table), Clear(x), !On(b,x)\n\n"
+            "        Move(b,x,y)\n"
+            "        Preconditions: On(b,x), Clear(b), Clear(y), Block(b), Block(y)\n"
+            "        Effects: On(b,y), Clear(x), !On(b,x), !Clear(y)\n";
+    return Instance{"Blocks", "blocks-" + to_string(blocks) + "-s" + to_string(seed), text};
+}
+
+// Triangles can only be on top of a tower, so they are placed after the blocks
+static vector<vector<string>> randomTriangleTowers(const vector<string> &blocks, const vector<string> &triangles, mt19937 &rng)
+{
+    vector<vector<string>> towers = randomTowers(blocks, rng);
+    vector<bool> capped(towers.size(), false);
+    for (const string &t : triangles) {
+        uniform_int_distribution<size_t> pick(0, towers.size());
+        size_t i = pick(rng);
+        if (i < towers.size() && !capped[i]) {
+            towers[i].push_back(t);
+            capped[i] = true;
+        } else {
+            towers.push_back(vector<string>(1, t));
+            capped.push_back(true);
+        }
+    }
+    return towers;
+}
+
+Instance generateBlocksTriangle(int blocks, int triangles, unsigned seed)
+{
+    mt19937 rng(seed);
+    vector<string> blockNames, triangleNames;
+    for (int i = 0; i < blocks; i++)
+        blockNames.push_back("B" + to_string(i));
+    for (int i = 0; i < triangles; i++)
+        triangleNames.push_back("T" + to_string(i));
+
+    vector<string> initial, goal;
+    towerFacts(randomTriangleTowers(blockNames, triangleNames, rng), initial, true);
+    for (const string &b : blockNames)
+        initial.push_back("Block(" + b + ")");
+    for (const string &t : triangleNames)
+        initial.push_back("Triangle(" + t + ")");
+    for (const string &b : blockNames)
+        initial.push_back("NotTable(" + b + ")");
+    for (const string &t : triangleNames)
+        initial.push_back("NotTable(" + t + ")");
+
+    // Like the original instance, the goal only fixes the items that are not on the table
+    vector<string> goalTowers;
+    towerFacts(randomTriangleTowers(blockNames, triangleNames, rng), goalTowers, false);
+    for (const string &fact : goalTowers)
+        if (fact.find(",Table)") == string::npos)
+            goal.push_back(fact);
+    if (goal.empty())
+        goal.push_back(goalTowers.front());
+
+    string text = "Symbols: " + joinFacts(blockNames) + ", " + joinFacts(triangleNames) + ", Table\n";
+    text += "Initial conditions: " + joinFacts(initial) + "\n";
+    text += "Goal conditions: " + joinFacts(goal) + "\n\n";
+    text += "Actions:\n"
+            "        MoveToTable(x,y)\n"
+            "        Preconditions: On(x,y), Clear(x), NotTable(x), NotTable(y), Block(y)\n"
+            "        Effects: On(x,Table), Clear(y), !On(x,y)\n\n"
+            "        Move(x,y,z)\n"
+            "        Preconditions: On(x,y), Block(z), Clear(z), Clear(x), NotTable(x), NotTable(z)\n"
+            "        Effects: Clear(y), On(x,z), !Clear(z), !On(x,y)\n";
+    return Instance{"BlocksTriangle", "blockstriangle-" + to_string(blocks) + "-" + to_string(triangles) + "-s" + to_string(seed), text};
+}
+
+// Rooms on a width x height grid; the goal G is behind a locked door next to one room
+Instance generateDoorKey(int width, int height, unsigned seed)
+{
+    mt19937 rng(seed);
+    vector<string> rooms;
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++)
+            rooms.push_back("R" + to_string(x) + "_" + to_string(y));
+
+    uniform_int_distribution<size_t> pickRoom(0, rooms.size() - 1);
+    vector<string> initial;
+    for (const string &r : rooms)
+        initial.push_back("Room(" + r + ")");
+    initial.push_back("Agent(A)");
+    initial.push_back("Key(K)");
+    initial.push_back("Door(D)");
+    initial.push_back("In(K," + rooms[pickRoom(rng)] + ")");
+    initial.push_back("In(A," + rooms[pickRoom(rng)] + ")");
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            string here = rooms[y * width + x];
+            if (x + 1 < width) {
+                string right = rooms[y * width + x + 1];
+                initial.push_back("Connected(" + here + "," + right + ")");
+                initial.push_back("Connected(" + right + "," + here + ")");
+            }
+            if (y + 1 < height) {
+                string down = rooms[(y + 1) * width + x];
+                initial.push_back("Connected(" + here + "," + down + ")");
+                initial.push_back("Connected(" + down + "," + here + ")");
+            }
+        }
+    }
+    string doorRoom = rooms[pickRoom(rng)];
+    initial.push_back("Connected(" + doorRoom + ",G)");
+    initial.push_back("Connected(G," + doorRoom + ")");
+    initial.push_back("Locked(D)");
+
+    string text = "Symbols: A, " + joinFacts(rooms) + ", G, K, D\n";
+    text += "Initial conditions: " + joinFacts(initial) + "\n";
+    text += "Goal conditions: In(A, G), HasKey(A)\n\n";
+    text += "Actions:\n"
+            "        MoveToRoom(x,y)\n"
+            "        Preconditions: Room(x), Room(y), Connected(x, y), Connected(y, x), In(A, x)\n"
+            "        Effects: !In(A, x), In(A, y)\n\n"
+            "        PickUpKey(x)\n"
+            "        Preconditions: Room(x), In(K, x), In(A, x), !HasKey(A)\n"
+            "        Effects: !In(K, x), HasKey(A)\n\n"
+            "        UnlockDoor(x)\n"
+            "        Preconditions: Room(x), Connected(x, G), Connected(G, x), In(A, x), HasKey(A), Locked(D)\n"
+            "        Effects: !Locked(D)\n\n"
+            "        MoveToGoal(x)\n"
+            "        Preconditions: Room(x), Connected(x, G), Connected(G, x), In(A, x), !Locked(D)\n"
+            "        Effects: !In(A, x), In(A, G)\n";
+    return Instance{"DoorKey", "doorkey-" + to_string(width) + "x" + to_string(height) + "-s" + to_string(seed), text};
+}
+
+// locations plain locations plus the water source W and the fire F
+Instance generateFireExtinguisher(int locations, unsigned seed)
+{
+    mt19937 rng(seed);
+    vector<string> locs;
+    for (int i = 0; i < locations; i++)
+        locs.push_back("L" + to_string(i));
+
+    uniform_int_distribution<size_t> pick(0, locs.size() - 1);
+    vector<string> initial = {"Quad(Q)", "Rob(R)", "At(Q," + locs[pick(rng)] + ")", "At(R," + locs[pick(rng)] + ")",
+                              "HighCharge(Q)", "InAir(Q)", "EmptyTank(Q)"};
+    for (const string &l : locs)
+        initial.push_back("Loc(" + l + ")");
+    initial.push_back("Loc(W)");
+    initial.push_back("Loc(F)");
+    initial.push_back("Fire(F)");
+
+    string text = "Symbols: " + joinFacts(locs) + ", W, F, Q, R\n";
+    text += "Initial conditions: " + joinFacts(initial) + "\n";
+    text += "Goal conditions: ExtThree(F)\n\n";
+    text += "Actions:\n"
+            "        MoveToLoc(x,y)\n"
+            "        Preconditions: Loc(x), Loc(y), At(R,x), InAir(Q)\n"
+            "        Effects: At(R,y), !At(R,x)\n\n"
+            "        MoveTogether(x,y)\n"
+            "        Preconditions: Loc(x), Loc(y), At(R,x), At(Q,x), OnRob(Q)\n"
+            "        Effects: !At(R,x), !At(Q,x), At(R,y), At(Q,y)\n\n"
+            "        TakeOffFromRob(z)\n"
+            "        Preconditions: Loc(z), At(R,z), At(Q,z), HighCharge(Q), OnRob(Q)\n"
+            "        Effects: InAir(Q), !OnRob(Q)\n\n"
+            "        LandOnRob(z)\n"
+            "        Preconditions: Loc(z), At(R,z), At(Q,z), InAir(Q)\n"
+            "        Effects: !InAir(Q), OnRob(Q)\n\n"
+            "        Charge(x)\n"
+            "        Preconditions: Quad(x), LowCharge(x), OnRob(x)\n"
+            "        Effects: !LowCharge(x), HighCharge(x)\n\n"
+            "        FillWater(x)\n"
+            "        Preconditions: Quad(x), OnRob(x), EmptyTank(x), At(R,W), At(Q,W)\n"
+            "        Effects: !EmptyTank(x), FullTank(Q)\n\n"
+            "        PourOnce(x)\n"
+            "        Preconditions: Fire(x), At(Q,x), InAir(Q), FullTank(Q), HighCharge(Q)\n"
+            "        Effects: ExtOne(x), EmptyTank(Q), !FullTank(Q), LowCharge(Q), !HighCharge(Q)\n\n"
+            "        PourTwice(x)\n"
+            "        Preconditions: Fire(x), At(Q,x), InAir(Q), FullTank(Q), HighCharge(Q), ExtOne(x)\n"
+            "        Effects: !ExtOne(x), ExtTwo(x), EmptyTank(Q), !FullTank(Q), LowCharge(Q), !HighCharge(Q)\n\n"
+            "        PourThrice(x)\n"
+            "        Preconditions: Fire(x), At(Q,x), InAir(Q), FullTank(Q), HighCharge(Q), ExtTwo(x)\n"
+            "        Effects: !ExtTwo(x), ExtThree(x), EmptyTank(Q), !FullTank(Q), LowCharge(Q), !HighCharge(Q)\n";
+    return Instance{"FireExtinguisher", "fire-" + to_string(locations) + "-s" + to_string(seed), text};
+}
+
+/////////////// Runs ///////////////
+
+struct Config
+{
+    string name;
+    vector<string> args; // appended after the environment file
+};
+
+struct RunResult
+{
+    bool finished = false; // exited normally within the timeout
+    bool solved = false;
+    double wall_ms = 0;
+    long peak_rss_kb = 0;
+    long expanded = 0;
+    long plan_cost = 0;
+};
+
+static long parseCounter(const string &output, const string &label)
+{
+    size_t pos = output.rfind(label);
+    if (pos == string::npos)
+        return -1;
+    return atol(output.c_str() + pos + label.size());
+}
+
+RunResult runPlanner(const string &planner, const string &envPath, const Config &config, double timeoutSec, const string &logPath)
+{
+    RunResult result;
+    auto start = chrono::steady_clock::now();
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        int fd = open(logPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        dup2(fd, STDOUT_FILENO);
+        dup2(fd, STDERR_FILENO);
+        vector<string> args = {planner, envPath};
+        args.insert(args.end(), config.args.begin(), config.args.end());
+        args.push_back("--progress");
+        args.push_back("off");
+        vector<char *> argv;
+        for (string &a : args)
+            argv.push_back(&a[0]);
+        argv.push_back(nullptr);
+        execv(planner.c_str(), argv.data());
+        _exit(127);
+    }
+
+    int status = 0;
+    struct rusage usage;
+    bool killed = false;
+    while (true) {
+        pid_t done = wait4(pid, &status, WNOHANG, &usage);
+        if (done == pid)
+            break;
+        double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        if (!killed && elapsed > timeoutSec) {
+            kill(pid, SIGKILL);
+            killed = true;
+        }
+        usleep(1000);
+    }
+    result.wall_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    result.peak_rss_kb = usage.ru_maxrss;
+    result.finished = !killed && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+
+    ifstream log(logPath);
+    stringstream contents;
+    contents << log.rdbuf();
+    string output = contents.str();
+    result.expanded = parseCounter(output, "States expanded: ");
+
+    size_t plan = output.rfind("\nPlan: \n");
+    if (result.finished && plan != string::npos) {
+        istringstream lines(output.substr(plan + 8));
+        string line;
+        long steps = 0;
+        while (getline(lines, line))
+            if (!line.empty() && line.find('(') != string::npos)
+                steps++;
+        // Unsolvable and limited runs also print an empty plan and their
+        // expansions, so the status line decides; planners without one only
+        // count as solved with a non-empty plan
+        size_t status = output.rfind("Status: ");
+        if (status != string::npos)
+            result.solved = output.compare(status + 8, 7, "solved\n") == 0;
+        else
+            result.solved = steps > 0;
+        // Planners that do not print a cost have unit action costs
+        result.plan_cost = parseCounter(output, "Plan cost: ");
+        if (result.plan_cost < 0)
+            result.plan_cost = steps;
+    }
+    return result;
+}
+
+static vector<int> parseList(const string &text)
+{
+    vector<int> values;
+    stringstream ss(text);
+    string item;
+    while (getline(ss, item, ','))
+        if (!item.empty())
+            values.push_back(atoi(item.c_str()));
+    return values;
+}
+
+static double median(vector<double> values)
+{
+    if (values.empty())
+        return 0;
+    sort(values.begin(), values.end());
+    size_t n = values.size();
+    return n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+}
+
+int main(int argc, char *argv[])
+{
+    // Usage: planner_bench [--planner path] [--reps N] [--timeout sec] [--seed S] [--format csv|json]
+    //                      [--out file] [--workdir dir] [--blocks 4,5,6] [--triangles 4,5]
+    //                      [--doorkey 2,3,4] [--fire 4,6,8] [--configs blind,ham,...]
+    string planner = PLANNER_PATH;
+    int reps = 3;
+    double timeoutSec = 60;
+    unsigned seed = 1;
+    string format = "csv";
+    string outPath;
+    string workdir;
+    vector<int> blockSizes = {4, 5, 6}, triangleSizes = {4, 5}, doorKeySizes = {2, 3, 4}, fireSizes = {4, 6, 8};
+    string configFilter;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        string value = i + 1 < argc ? argv[i + 1] : "";
+        if (arg == "--planner") planner = value, i++;
+        else if (arg == "--reps") reps = max(1, atoi(value.c_str())), i++;
+        else if (arg == "--timeout") timeoutSec = atof(value.c_str()), i++;
+        else if (arg == "--seed") seed = strtoul(value.c_str(), nullptr, 10), i++;
+        else if (arg == "--format") format = value, i++;
+        else if (arg == "--out") outPath = value, i++;
+        else if (arg == "--workdir") workdir = value, i++;
+        else if (arg == "--blocks") blockSizes = parseList(value), i++;
+        else if (arg == "--triangles") triangleSizes = parseList(value), i++;
+        else if (arg == "--doorkey") doorKeySizes = parseList(value), i++;
+        else if (arg == "--fire") fireSizes = parseList(value), i++;
+        else if (arg == "--configs") configFilter = "," + value + ",", i++;
+        else {
+            cerr << "Unknown argument " << arg << endl;
+            return 1;
+        }
+    }
+
+    if (workdir.empty()) {
+        char pattern[] = "/tmp/planner_bench_XXXXXX";
+        if (!mkdtemp(pattern)) {
+            cerr << "Unable to create a work directory" << endl;
+            return 1;
+        }
+        workdir = pattern;
+    }
+
+    vector<Instance> instances;
+    for (int n : blockSizes)
+        instances.push_back(generateBlocks(n, seed));
+    for (int n : triangleSizes)
+        instances.push_back(generateBlocksTriangle(n, max(1, n / 2), seed));
+    for (int n : doorKeySizes)
+        instances.push_back(generateDoorKey(n, n, seed));
+    for (int n : fireSizes)
+        instances.push_back(generateFireExtinguisher(n, seed));
+
+    // Every heuristic with every search mode
+    vector<Config> configs;
+    vector<pair<string, vector<string>>> heuristics = {
+        {"blind", {"0"}}, {"ham", {"1", "ham"}}, {"edl", {"1", "edl"}}, {"hmax", {"1", "hmax"}}, {"hadd", {"1", "hadd"}}};
+    vector<pair<string, vector<string>>> modes = {{"", {}}, {"lifted", {"--lifted"}}, {"por", {"--por"}}, {"symmetry", {"--symmetry"}}};
+    for (const auto &h : heuristics) {
+        for (const auto &m : modes) {
+            // h_max and h_add need the grounded task
+            if (m.first == "lifted" && (h.first == "hmax" || h.first == "hadd"))
+                continue;
+            Config config{h.first + (m.first.empty() ? "" : "+" + m.first), h.second};
+            config.args.insert(config.args.end(), m.second.begin(), m.second.end());
+            if (configFilter.empty() || configFilter.find("," + config.name + ",") != string::npos)
+                configs.push_back(config);
+        }
+    }
+    // Every tie-breaking policy besides the default one, on the grounded task
+    for (const auto &h : heuristics) {
+        for (const char *policy : {"h-fifo", "lifo", "fifo", "random"}) {
+            Config config{h.first + "+" + policy, h.second};
+            config.args.insert(config.args.end(), {"--tie-breaking", policy, "--seed", to_string(seed)});
+            if (configFilter.empty() || configFilter.find("," + config.name + ",") != string::npos)
+                configs.push_back(config);
+        }
+    }
+    // The remaining search options, each on its own
+    for (const Config &config : {Config{"blind+frontier", {"0", "--frontier"}}, Config{"iw", {"0", "--iw"}},
+                                 Config{"bfws", {"0", "--bfws"}}, Config{"edl+invariants", {"1", "edl", "--invariants"}},
+                                 Config{"hadd+reopen", {"1", "hadd", "--reopen"}},
+                                 Config{"blind+no-parents", {"0", "--no-parents"}},
+                                 Config{"edl+lookahead", {"1", "edl", "--lookahead", "4"}}}) {
+        if (configFilter.empty() || configFilter.find("," + config.name + ",") != string::npos)
+            configs.push_back(config);
+    }
+
+    ofstream outFile;
+    if (!outPath.empty())
+        outFile.open(outPath);
+    ostream &out = outPath.empty() ? cout : outFile;
+
+    if (format == "csv")
+        out << "domain,instance,config,reps,solved,median_wall_ms,expanded,expansions_per_sec,peak_rss_kb,plan_cost" << endl;
+    else
+        out << "[" << endl;
+
+    bool first = true;
+    for (const Instance &instance : instances) {
+        string envPath = workdir + "/" + instance.name + ".txt";
+        ofstream(envPath) << instance.text;
+
+        for (const Config &config : configs) {
+            vector<double> walls;
+            long peakRss = 0, expanded = -1, cost = -1;
+            int solved = 0;
+            for (int r = 0; r < reps; r++) {
+                RunResult run = runPlanner(planner, envPath, config, timeoutSec, workdir + "/run.log");
+                cerr << instance.name << " " << config.name << " rep " << r + 1 << ": "
+                     << (run.finished ? (run.solved ? "solved" : "unsolved") : "timeout") << " " << run.wall_ms << " ms" << endl;
+                walls.push_back(run.wall_ms);
+                peakRss = max(peakRss, run.peak_rss_kb);
+                if (run.solved) {
+                    solved++;
+                    expanded = run.expanded;
+                    cost = run.plan_cost;
+                }
+                // Repeating a run that timed out only burns time
+                if (!run.finished)
+                    break;
+            }
+
+            double wall = median(walls);
+            double rate = expanded > 0 && wall > 0 ? expanded / (wall / 1000.0) : 0;
+            if (format == "csv") {
+                out << instance.domain << "," << instance.name << "," << config.name << "," << walls.size() << ","
+                    << solved << "," << wall << "," << expanded << "," << rate << "," << peakRss << "," << cost << endl;
+            } else {
+                out << (first ? "" : ",\n") << "  {\"domain\":\"" << instance.domain << "\",\"instance\":\"" << instance.name
+                    << "\",\"config\":\"" << config.name << "\",\"reps\":" << walls.size() << ",\"solved\":" << solved
+                    << ",\"median_wall_ms\":" << wall << ",\"expanded\":" << expanded << ",\"expansions_per_sec\":" << rate
+                    << ",\"peak_rss_kb\":" << peakRss << ",\"plan_cost\":" << cost << "}";
+            }
+            first = false;
+        }
+    }
+
+    if (format != "csv")
+        out << "\n]" << endl;
+    return 0;
+}
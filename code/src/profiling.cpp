@@ -0,0 +1,59 @@
+#include "planner/profiling.h"
+
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+#ifdef PLANNER_PROFILING
+
+void Profiler::writeSummary()
+{
+    lock_guard<mutex> guard(lock);
+    string timers, counters, histograms;
+    for (const auto &entry : sites) {
+        const ProfileSite &s = *entry.second;
+        string item = "\"" + s.name + "\":";
+        if (s.kind == ProfileSite::TIMER) {
+            item += "{\"calls\":" + to_string(s.count.load()) + ",\"total_ms\":" + to_string(s.total_ns.load() / 1e6) + "}";
+            timers += (timers.empty() ? "" : ",") + item;
+        } else if (s.kind == ProfileSite::COUNTER) {
+            item += to_string(s.count.load());
+            counters += (counters.empty() ? "" : ",") + item;
+        } else {
+            uint64_t n = s.count.load();
+            item += "{\"count\":" + to_string(n) + ",\"mean\":" + to_string(n ? s.sum_milli.load() / 1000.0 / n : 0.0) + ",\"buckets\":{";
+            bool first = true;
+            for (int b = 0; b < ProfileSite::NUM_BUCKETS; b++) {
+                if (s.buckets[b].load() == 0)
+                    continue;
+                item += string(first ? "" : ",") + "\"" + to_string(ProfileSite::bucketLowerBound(b)) + "\":" + to_string(s.buckets[b].load());
+                first = false;
+            }
+            item += "}}";
+            histograms += (histograms.empty() ? "" : ",") + item;
+        }
+    }
+    string json = "{\"timers\":{" + timers + "},\"counters\":{" + counters + "},\"histograms\":{" + histograms + "}}";
+    if (summary_path.empty()) {
+        cerr << json << endl;
+    } else {
+        ofstream(summary_path) << json << endl;
+    }
+
+    if (tracing) {
+        ofstream trace(trace_path);
+        trace << "{\"traceEvents\":[";
+        bool first = true;
+        for (const auto &buffer : traceBuffers) {
+            for (const TraceEvent &e : *buffer.second) {
+                trace << (first ? "" : ",\n") << "{\"name\":\"" << e.site->name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                      << buffer.first << ",\"ts\":" << e.start_ns / 1000.0 << ",\"dur\":" << e.duration_ns / 1000.0 << "}";
+                first = false;
+            }
+        }
+        trace << "]}" << endl;
+    }
+}
+
+#endif
@@ -0,0 +1,161 @@
+#include "planner/realtime_search.h"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+using namespace std;
+
+RealTimeSearch::RealTimeSearch(const TaskView &task, const SearchOptions &options, uint32_t lookahead)
+    : task(task), options(options), space(task, this->options), lookahead(max<uint32_t>(lookahead, 1))
+{
+    if (!parseTieBreaking(options.tie_breaking, tieBreaking))
+        throw runtime_error("Unknown tie-breaking policy " + options.tie_breaking);
+}
+
+uint32_t RealTimeSearch::lookup(const PackedState &state)
+{
+    auto found = hTable.find(state);
+    if (found != hTable.end())
+        return found->second;
+    PROFILE_SCOPE("heuristic");
+    uint32_t h = space.heuristic(state);
+    hTable.emplace(state, h);
+    return h;
+}
+
+bool RealTimeSearch::step(const PackedState &state, uint32_t &action)
+{
+    PROFILE_SCOPE("realtime_step");
+    if (isGoal(task, state))
+        return false;
+
+    BucketOpenList<Node> openList(tieBreaking, options.tie_breaking_seed);
+    unordered_map<PackedState, StateRecord<Node>, PackedStateHasher> records;
+    vector<unique_ptr<Node>> nodes;
+    vector<Node *> expanded;
+
+    nodes.emplace_back(new Node{state, 0, lookup(state), 0, nullptr, -1});
+    Node *start = nodes.back().get();
+    start->f = start->h;
+    if (start->h == INFINITE_COST)
+        return false;
+    openList.push(start);
+    records[state].g = 0;
+    records[state].node = start;
+
+    // Bounded A*: stop at a goal or once the lookahead is used up, leaving the best node open
+    vector<uint32_t> applicable;
+    PackedState neighbor;
+    Node *best = nullptr;
+    while (!openList.empty()) {
+        Node *current = openList.top();
+        StateRecord<Node> &record = records[current->state];
+        if (record.node != current) {
+            openList.pop();
+            continue;
+        }
+        if (expanded.size() == lookahead || space.is_goal(current->state)) {
+            best = current;
+            break;
+        }
+        openList.pop();
+        record.closed = true;
+        expanded.push_back(current);
+        states_expanded++;
+
+        space.applicable_actions(current->state, applicable);
+        for (uint32_t a : applicable) {
+            space.apply(current->state, a, neighbor);
+            states_generated++;
+            uint32_t g = current->g + space.action_cost(a);
+            StateRecord<Node> &next = records[neighbor];
+            if (next.closed || g >= next.g)
+                continue;
+            uint32_t h = next.node ? next.node->h : lookup(neighbor);
+            next.g = g;
+            if (h == INFINITE_COST)
+                continue;
+            nodes.emplace_back(new Node{neighbor, g, h, g + h, current, (int32_t)a});
+            next.node = nodes.back().get();
+            openList.push(next.node);
+        }
+    }
+
+    // Nothing left open: every state reachable from here has been expanded without a goal
+    if (!best) {
+        for (Node *node : expanded)
+            hTable[node->state] = INFINITE_COST;
+        return false;
+    }
+
+    // RTAA* update; with a consistent heuristic f* - g(s) is never below h(s),
+    // the max only matters for inconsistent ones, which can also expand states
+    // with g above f* that then learn nothing
+    uint32_t fBest = best->g + best->h;
+    for (Node *node : expanded) {
+        uint32_t &h = hTable[node->state];
+        if (node->g < fBest)
+            h = max(h, fBest - node->g);
+    }
+
+    Node *first = best;
+    while (first->parent != start)
+        first = first->parent;
+    action = first->action;
+    return true;
+}
+
+RealTimeResult realTimeSearch(const TaskView &task, const SearchOptions &options, uint32_t lookahead, uint32_t trials,
+                              uint32_t max_steps)
+{
+    RealTimeResult result;
+    RealTimeSearch search(task, options, lookahead);
+    SearchGuard guard(options);
+    unique_ptr<ProgressReporter> progress;
+    if (options.progress_format != "off")
+        progress.reset(new ProgressReporter(options.progress_format, options.progress_interval_ms));
+
+    PackedState state, next;
+    for (uint32_t trial = 0; trial < max<uint32_t>(trials, 1); trial++) {
+        state = task.initial_state();
+        result.plan.clear();
+        result.cost = 0;
+        result.status = SEARCH_UNSOLVABLE;
+
+        uint32_t action;
+        while (!isGoal(task, state)) {
+            if (guard.exceeded(search.states_expanded, result.status))
+                break;
+            if (result.plan.size() == max_steps) {
+                result.status = SEARCH_STEP_LIMIT;
+                break;
+            }
+            if (!search.step(state, action))
+                break;
+            applyAction(task, state, action, next);
+            state.swap(next);
+            result.plan.push_back(action);
+            result.cost += task.action_cost(action);
+            if (progress)
+                progress->tick(search.states_expanded, search.states_generated, 0, search.learned_states(), result.cost,
+                               search.h(state));
+        }
+        if (isGoal(task, state))
+            result.status = SEARCH_SOLVED;
+        result.trial_costs.push_back(result.cost);
+        if (!result.solved())
+            break;
+    }
+
+    result.states_expanded = search.states_expanded;
+    result.states_generated = search.states_generated;
+    result.learned_states = search.learned_states();
+
+    // Learned values stay admissible if the heuristic is
+    uint32_t hInitial = search.h(task.initial_state());
+    result.f_bound = hInitial == INFINITE_COST ? numeric_limits<float>::infinity() : hInitial;
+    if (result.solved())
+        result.f_bound = min<float>(result.f_bound, result.cost);
+    return result;
+}
@@ -0,0 +1,226 @@
+#include "planner/engine.h"
+#include "planner/state_registry.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Microbenchmark of StateRegistry against the single locked map a parallel
+// search would otherwise share. The states are the reachable states of the
+// environments in envs/, breadth-first up to --states each. Every thread
+// inserts its share of a random stream of them in batches, as a search inserts
+// the successors of an expansion, then looks up another stream; insert and
+// lookup throughput is printed as CSV for every thread count.
+
+#ifndef ENVS_DIR
+#define ENVS_DIR "../envs"
+#endif
+
+using namespace std;
+
+static vector<int> parseList(const string &text)
+{
+    vector<int> values;
+    stringstream ss(text);
+    string item;
+    while (getline(ss, item, ','))
+        if (!item.empty())
+            values.push_back(atoi(item.c_str()));
+    return values;
+}
+
+static vector<string> parseNames(const string &text)
+{
+    vector<string> names;
+    stringstream ss(text);
+    string item;
+    while (getline(ss, item, ','))
+        if (!item.empty())
+            names.push_back(item);
+    return names;
+}
+
+// Reachable states, breadth-first
+static vector<PackedState> reachableStates(const TaskView &task, size_t limit)
+{
+    vector<PackedState> states{task.initial_state()};
+    unordered_set<PackedState, PackedStateHasher> seen(states.begin(), states.end());
+    vector<uint32_t> applicable;
+    PackedState current, next;
+    for (size_t i = 0; i < states.size() && states.size() < limit; i++) {
+        current = states[i];
+        getApplicableActions(task, current, applicable);
+        for (uint32_t a : applicable) {
+            applyAction(task, current, a, next);
+            if (seen.insert(next).second) {
+                states.push_back(next);
+                if (states.size() == limit)
+                    break;
+            }
+        }
+    }
+    return states;
+}
+
+// Seconds for threads running work(t) together
+template <typename Work>
+static double timeThreads(int threads, Work work)
+{
+    atomic<int> ready(0);
+    atomic<bool> start(false);
+    vector<thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            ready++;
+            while (!start.load())
+                this_thread::yield();
+            work(t);
+        });
+    }
+    while (ready.load() < threads)
+        this_thread::yield();
+    auto begin = chrono::steady_clock::now();
+    start = true;
+    for (thread &worker : workers)
+        worker.join();
+    return chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+}
+
+// The baseline: one map and one lock for all threads
+struct LockedMap
+{
+    mutex lock;
+    unordered_map<PackedState, uint32_t, PackedStateHasher> ids;
+};
+
+int main(int argc, char *argv[])
+{
+    // Usage: registry_bench [--envs Blocks,BlocksTriangle,DoorKey,FireExtinguisher | paths]
+    //                       [--threads 1,2,4,8,16,32,64] [--states N] [--ops N] [--batch N]
+    //                       [--shards N] [--seed S]
+    vector<string> envs = {"Blocks", "BlocksTriangle", "DoorKey", "FireExtinguisher"};
+    vector<int> threadCounts = {1, 2, 4, 8, 16, 32, 64};
+    size_t maxStates = 1 << 20;
+    size_t ops = 1 << 21; // per phase, split among the threads
+    int batch = 16;
+    int shards = 64;
+    unsigned seed = 1;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        string value = i + 1 < argc ? argv[i + 1] : "";
+        if (arg == "--envs") envs = parseNames(value), i++;
+        else if (arg == "--threads") threadCounts = parseList(value), i++;
+        else if (arg == "--states") maxStates = max(1L, atol(value.c_str())), i++;
+        else if (arg == "--ops") ops = max(1L, atol(value.c_str())), i++;
+        else if (arg == "--batch") batch = max(1, atoi(value.c_str())), i++;
+        else if (arg == "--shards") shards = max(1, atoi(value.c_str())), i++;
+        else if (arg == "--seed") seed = strtoul(value.c_str(), nullptr, 10), i++;
+        else {
+            cerr << "Unknown argument " << arg << endl;
+            return 1;
+        }
+    }
+
+    cerr << "Hardware threads: " << thread::hardware_concurrency() << endl;
+    cout << "domain,states,impl,threads,batch,insert_mops,lookup_mops" << endl;
+
+    for (const string &name : envs) {
+        string path = name.find('/') == string::npos ? string(ENVS_DIR) + "/" + name + ".txt" : name;
+        string domain = path.substr(path.rfind('/') + 1);
+        domain = domain.substr(0, domain.rfind('.'));
+        Env *env;
+        try {
+            env = create_env(const_cast<char *>(path.c_str()));
+        } catch (const runtime_error &e) {
+            cerr << e.what() << endl;
+            return 1;
+        }
+        PlannerEngine engine;
+        engine.load(*env);
+        delete env;
+        const TaskView &task = engine.task();
+        vector<PackedState> pool = reachableStates(task, maxStates);
+
+        for (int threads : threadCounts) {
+            if (threads < 1)
+                continue;
+            size_t perThread = max<size_t>(ops / threads, 1);
+            size_t total = perThread * threads;
+
+            // The same streams for both implementations; lookups use a second one
+            vector<vector<uint32_t>> inserts(threads), lookups(threads);
+            for (int t = 0; t < threads; t++) {
+                mt19937 rng(seed + t);
+                uniform_int_distribution<uint32_t> pick(0, pool.size() - 1);
+                for (size_t k = 0; k < perThread; k++) {
+                    inserts[t].push_back(pick(rng));
+                    lookups[t].push_back(pick(rng));
+                }
+            }
+
+            LockedMap map;
+            double mapInsert = timeThreads(threads, [&](int t) {
+                for (uint32_t i : inserts[t]) {
+                    lock_guard<mutex> guard(map.lock);
+                    map.ids.emplace(pool[i], (uint32_t)map.ids.size());
+                }
+            });
+            atomic<size_t> mapFound(0);
+            double mapLookup = timeThreads(threads, [&](int t) {
+                size_t found = 0;
+                for (uint32_t i : lookups[t]) {
+                    lock_guard<mutex> guard(map.lock);
+                    found += map.ids.count(pool[i]);
+                }
+                mapFound += found;
+            });
+
+            StateRegistry registry(task.state_words(), shards);
+            vector<StateRegistry::Writer> writers;
+            for (int t = 0; t < threads; t++)
+                writers.push_back(registry.writer());
+            double registryInsert = timeThreads(threads, [&](int t) {
+                vector<PackedState> states(batch);
+                vector<uint32_t> ids;
+                vector<bool> added;
+                for (size_t k = 0; k < inserts[t].size(); k += batch) {
+                    states.resize(min<size_t>(batch, inserts[t].size() - k));
+                    for (size_t j = 0; j < states.size(); j++)
+                        states[j] = pool[inserts[t][k + j]];
+                    writers[t].insert(states, ids, added);
+                }
+            });
+            atomic<size_t> registryFound(0);
+            double registryLookup = timeThreads(threads, [&](int t) {
+                size_t found = 0;
+                uint32_t id;
+                for (uint32_t i : lookups[t])
+                    found += registry.find(pool[i], id);
+                registryFound += found;
+            });
+
+            if (registry.size() != map.ids.size() || registryFound != mapFound) {
+                cerr << domain << ": the registry holds " << registry.size() << " states and found " << registryFound
+                     << ", the map " << map.ids.size() << " and " << mapFound << endl;
+                return 1;
+            }
+
+            cout << domain << "," << pool.size() << ",locked-map," << threads << ",1," << total / mapInsert / 1e6 << ","
+                 << total / mapLookup / 1e6 << endl;
+            cout << domain << "," << pool.size() << ",registry," << threads << "," << batch << ","
+                 << total / registryInsert / 1e6 << "," << total / registryLookup / 1e6 << endl;
+        }
+    }
+    return 0;
+}
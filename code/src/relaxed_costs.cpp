@@ -0,0 +1,196 @@
+#include "planner/relaxed_costs.h"
+#include "planner/profiling.h"
+
+#include <algorithm>
+#include <functional>
+
+using namespace std;
+
+static const uint32_t UNREACHED = INFINITE_COST;
+
+RelaxedCostHeuristic::RelaxedCostHeuristic(const TaskView &task, RelaxedAggregation aggregation)
+    : task(task), aggregation(aggregation), preconditions(task.num_actions()), addEffects(task.num_actions()),
+      preconditionOf(task.num_facts()), achievers(task.num_facts()), cost(task.num_facts(), UNREACHED),
+      supporter(task.num_facts(), -1), isAffected(task.num_facts(), false), pendingPreconditions(task.num_actions())
+{
+    auto forEachFact = [&](const uint64_t *mask, vector<uint32_t> &out) {
+        for (uint32_t w = 0; w < task.state_words(); w++) {
+            uint64_t bits = mask[w];
+            while (bits) {
+                out.push_back(w * 64 + __builtin_ctzll(bits));
+                bits &= bits - 1;
+            }
+        }
+    };
+    for (uint32_t a = 0; a < task.num_actions(); a++) {
+        forEachFact(task.mask(a, MASK_PRE_POS), preconditions[a]);
+        forEachFact(task.mask(a, MASK_ADD), addEffects[a]);
+        for (uint32_t f : preconditions[a])
+            preconditionOf[f].push_back(a);
+        for (uint32_t f : addEffects[a])
+            achievers[f].push_back(a);
+    }
+}
+
+uint32_t RelaxedCostHeuristic::actionCost(uint32_t a) const
+{
+    uint32_t total = 0;
+    for (uint32_t f : preconditions[a]) {
+        if (cost[f] == UNREACHED)
+            return UNREACHED;
+        total = aggregation == RELAXED_ADD ? total + cost[f] : max(total, cost[f]);
+    }
+    return task.action_cost(a) + total;
+}
+
+// Lower the cost of f to c and queue it; larger costs are ignored
+void RelaxedCostHeuristic::push(uint32_t f, uint32_t c, int32_t achiever)
+{
+    if (c >= cost[f])
+        return;
+    cost[f] = c;
+    supporter[f] = achiever;
+    heap.emplace_back(c, f);
+    push_heap(heap.begin(), heap.end(), greater<pair<uint32_t, uint32_t>>());
+    PROFILE_COUNT("relaxed_cost_updates", 1);
+}
+
+// Pass cost decreases on until no achiever gets cheaper
+void RelaxedCostHeuristic::propagate()
+{
+    while (!heap.empty()) {
+        pop_heap(heap.begin(), heap.end(), greater<pair<uint32_t, uint32_t>>());
+        pair<uint32_t, uint32_t> top = heap.back();
+        heap.pop_back();
+        if (top.first > cost[top.second])
+            continue;
+        for (uint32_t a : preconditionOf[top.second]) {
+            uint32_t c = actionCost(a);
+            if (c == UNREACHED)
+                continue;
+            for (uint32_t f : addEffects[a])
+                push(f, c, a);
+        }
+    }
+}
+
+// Costs from scratch. Facts leave the heap in cost order, so an action's cost
+// is final once its last precondition is popped.
+void RelaxedCostHeuristic::recompute(const PackedState &state)
+{
+    fill(cost.begin(), cost.end(), UNREACHED);
+    fill(supporter.begin(), supporter.end(), -1);
+    heap.clear();
+
+    for (uint32_t f = 0; f < task.num_facts(); f++) {
+        if (testFact(state, f))
+            push(f, 0, -1);
+    }
+    for (uint32_t a = 0; a < task.num_actions(); a++) {
+        pendingPreconditions[a] = preconditions[a].size();
+        if (preconditions[a].empty()) {
+            for (uint32_t f : addEffects[a])
+                push(f, task.action_cost(a), a);
+        }
+    }
+
+    while (!heap.empty()) {
+        pop_heap(heap.begin(), heap.end(), greater<pair<uint32_t, uint32_t>>());
+        pair<uint32_t, uint32_t> top = heap.back();
+        heap.pop_back();
+        if (top.first > cost[top.second])
+            continue;
+        for (uint32_t a : preconditionOf[top.second]) {
+            if (--pendingPreconditions[a] > 0)
+                continue;
+            uint32_t c = actionCost(a);
+            for (uint32_t f : addEffects[a])
+                push(f, c, a);
+        }
+    }
+}
+
+// Move the kept costs from current to state
+void RelaxedCostHeuristic::update(const PackedState &state)
+{
+    heap.clear();
+
+    // Facts no longer true, and transitively the facts whose supporter needs
+    // one of them, lose their cost
+    affected.clear();
+    for (uint32_t w = 0; w < task.state_words(); w++) {
+        uint64_t removed = current[w] & ~state[w];
+        while (removed) {
+            uint32_t f = w * 64 + __builtin_ctzll(removed);
+            removed &= removed - 1;
+            isAffected[f] = true;
+            affected.push_back(f);
+        }
+    }
+    for (size_t i = 0; i < affected.size(); i++) {
+        for (uint32_t a : preconditionOf[affected[i]]) {
+            for (uint32_t f : addEffects[a]) {
+                if (supporter[f] == (int32_t)a && !isAffected[f]) {
+                    isAffected[f] = true;
+                    affected.push_back(f);
+                }
+            }
+        }
+    }
+    for (uint32_t f : affected) {
+        cost[f] = UNREACHED;
+        supporter[f] = -1;
+    }
+
+    // Rebuild them from the achievers whose preconditions kept their cost
+    for (uint32_t f : affected) {
+        isAffected[f] = false;
+        for (uint32_t a : achievers[f])
+            push(f, actionCost(a), a);
+    }
+
+    // Facts that became true cost nothing
+    for (uint32_t w = 0; w < task.state_words(); w++) {
+        uint64_t added = state[w] & ~current[w];
+        while (added) {
+            uint32_t f = w * 64 + __builtin_ctzll(added);
+            added &= added - 1;
+            push(f, 0, -1);
+        }
+    }
+
+    propagate();
+}
+
+uint32_t RelaxedCostHeuristic::goalCost() const
+{
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < task.header->num_goals; i++) {
+        uint32_t c = cost[task.goal[i]];
+        if (c == UNREACHED)
+            return UNREACHED;
+        total = aggregation == RELAXED_ADD ? total + c : max(total, c);
+    }
+    return total;
+}
+
+uint32_t RelaxedCostHeuristic::evaluate(const PackedState &state)
+{
+    PROFILE_SCOPE("relaxed_costs");
+
+    // Updating pays off while few facts differ; past that, start over
+    uint32_t changed = 0;
+    if (valid) {
+        for (uint32_t w = 0; w < task.state_words(); w++)
+            changed += __builtin_popcountll(current[w] ^ state[w]);
+    }
+    if (!valid || changed * 4 > task.num_facts()) {
+        PROFILE_COUNT("relaxed_cost_recomputes", 1);
+        recompute(state);
+        valid = true;
+    } else if (changed > 0) {
+        update(state);
+    }
+    current = state;
+    return goalCost();
+}
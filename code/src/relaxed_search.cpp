@@ -0,0 +1,190 @@
+#include "planner/relaxed_search.h"
+#include "planner/profiling.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+OptimalRelaxedSearch::OptimalRelaxedSearch(const TaskView &task)
+    : task(task), words(task.state_words()), achievers(task.num_facts()), hmax(task, RELAXED_MAX), key(words, 0)
+{
+    for (uint32_t a = 0; a < task.num_actions(); a++) {
+        const uint64_t *add = task.mask(a, MASK_ADD);
+        for (uint32_t w = 0; w < words; w++) {
+            for (uint64_t bits = add[w]; bits; bits &= bits - 1)
+                achievers[w * 64 + __builtin_ctzll(bits)].push_back(a);
+        }
+    }
+    findRelevant();
+}
+
+// Backwards from the goal: achievers of relevant facts are relevant, and so
+// are their preconditions
+void OptimalRelaxedSearch::findRelevant()
+{
+    goalFacts.assign(task.goal, task.goal + task.header->num_goals);
+    relevantAction.assign(task.num_actions(), false);
+    relevantFacts.assign(words, 0);
+    vector<uint32_t> pending(goalFacts);
+    for (uint32_t f : pending)
+        relevantFacts[f / 64] |= uint64_t(1) << (f % 64);
+    while (!pending.empty()) {
+        uint32_t f = pending.back();
+        pending.pop_back();
+        for (uint32_t a : achievers[f]) {
+            if (relevantAction[a])
+                continue;
+            relevantAction[a] = true;
+            const uint64_t *pre = task.mask(a, MASK_PRE_POS);
+            for (uint32_t w = 0; w < words; w++) {
+                for (uint64_t bits = pre[w] & ~relevantFacts[w]; bits; bits &= bits - 1) {
+                    uint32_t p = w * 64 + __builtin_ctzll(bits);
+                    relevantFacts[w] |= uint64_t(1) << (p % 64);
+                    pending.push_back(p);
+                }
+            }
+        }
+    }
+}
+
+void OptimalRelaxedSearch::retarget(const TaskView &instance)
+{
+    task = instance;
+    hmax.retarget(instance);
+    if (goalFacts.size() == task.header->num_goals && equal(goalFacts.begin(), goalFacts.end(), task.goal))
+        return;
+    findRelevant();
+    memo.clear();
+}
+
+static uint64_t hashWords(const uint64_t *s, uint32_t words)
+{
+    uint64_t x = 0;
+    for (uint32_t w = 0; w < words; w++) {
+        x = (x ^ s[w]) * 0x9e3779b97f4a7c15ull;
+        x ^= x >> 32;
+    }
+    return x;
+}
+
+// Double the id table and put back the states of this call
+void OptimalRelaxedSearch::grow()
+{
+    size_t capacity = max<size_t>(slots.size() * 2, 1024);
+    slots.assign(capacity, 0);
+    stamps.assign(capacity, 0);
+    stamp = 1;
+    for (uint32_t id = 0; id < used; id++) {
+        size_t i = hashWords(stateWords(id), words) & (capacity - 1);
+        while (stamps[i] == stamp)
+            i = (i + 1) & (capacity - 1);
+        stamps[i] = stamp;
+        slots[i] = id;
+    }
+}
+
+// Id of the state, added to the arena if new
+uint32_t OptimalRelaxedSearch::intern(const uint64_t *s, bool &added)
+{
+    if ((used + 1) * 2 > slots.size())
+        grow();
+    size_t mask = slots.size() - 1;
+    for (size_t i = hashWords(s, words) & mask;; i = (i + 1) & mask) {
+        if (stamps[i] != stamp) {
+            if (arena.size() < (used + 1) * words)
+                arena.resize(max(arena.size() * 2, (used + 1) * words));
+            copy(s, s + words, arena.begin() + used * words);
+            stamps[i] = stamp;
+            slots[i] = used;
+            added = true;
+            return used++;
+        }
+        if (memcmp(stateWords(slots[i]), s, words * sizeof(uint64_t)) == 0) {
+            added = false;
+            return slots[i];
+        }
+    }
+}
+
+uint32_t OptimalRelaxedSearch::evaluate(const PackedState &start, const atomic<bool> *cancel)
+{
+    PROFILE_SCOPE("edl_search");
+    PROFILE_COUNT("edl_searches", 1);
+
+    for (uint32_t w = 0; w < words; w++)
+        key[w] = start[w] & relevantFacts[w];
+    auto known = memo.find(key);
+    if (known != memo.end()) {
+        memo_hits++;
+        PROFILE_COUNT("edl_memo_hits", 1);
+        return known->second;
+    }
+
+    uint32_t hStart = hmax.evaluate(start);
+    if (hStart == INFINITE_COST) {
+        memo.emplace(key, 0);
+        return 0;
+    }
+
+    // A new call: forget the states of the last one
+    if (++stamp == 0) {
+        fill(stamps.begin(), stamps.end(), 0);
+        stamp = 1;
+    }
+    used = 0;
+    openList.clear();
+    auto initEntry = [&](uint32_t id, uint32_t h) -> Entry & {
+        if (id == entries.size())
+            entries.emplace_back();
+        entries[id] = Entry{INFINITE_COST, h, 0, id, false};
+        return entries[id];
+    };
+
+    bool added;
+    Entry &root = initEntry(intern(start.data(), added), hStart);
+    root.g = 0;
+    root.f = hStart;
+    openList.push(&root);
+
+    uint32_t h = 0;
+    while (!openList.empty()) {
+        // Give up on cancellation; 0 is still an admissible estimate
+        if (cancel && cancel->load(memory_order_relaxed))
+            return 0;
+
+        Entry *current = openList.top();
+        openList.pop();
+        if (current->closed)
+            continue;
+        current->closed = true;
+        PROFILE_COUNT("edl_expansions", 1);
+
+        state.assign(stateWords(current->id), stateWords(current->id) + words);
+        if (isGoalEDL(task, state)) {
+            h = current->g;
+            break;
+        }
+
+        getApplicableActionsEDL(task, state, applicable);
+        for (uint32_t a : applicable) {
+            if (!relevantAction[a])
+                continue;
+            applyActionEDL(task, state, a, neighbor);
+            if (neighbor == state)
+                continue;
+
+            uint32_t g = current->g + task.action_cost(a);
+            uint32_t id = intern(neighbor.data(), added);
+            Entry &next = added ? initEntry(id, hmax.evaluate(neighbor)) : entries[id];
+            if (next.closed || g >= next.g)
+                continue;
+            next.g = g;
+            next.f = g + next.h;
+            openList.push(&next);
+        }
+    }
+
+    memo.emplace(key, h);
+    return h;
+}
@@ -0,0 +1,100 @@
+#include "planner/search.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <unistd.h>
+
+using namespace std;
+
+const char *searchStatusName(SearchStatus status)
+{
+    switch (status) {
+    case SEARCH_SOLVED:
+        return "solved";
+    case SEARCH_UNSOLVABLE:
+        return "unsolvable";
+    case SEARCH_TIMEOUT:
+        return "timeout";
+    case SEARCH_EXPANSION_LIMIT:
+        return "expansion_limit";
+    case SEARCH_STEP_LIMIT:
+        return "step_limit";
+    case SEARCH_OUT_OF_MEMORY:
+        return "out_of_memory";
+    case SEARCH_CANCELLED:
+        return "cancelled";
+    }
+    return "unknown";
+}
+
+double residentMegabytes()
+{
+    long pages = 0, resident = 0;
+    ifstream statm("/proc/self/statm");
+    if (!(statm >> pages >> resident))
+        return 0;
+    return resident * (double)sysconf(_SC_PAGESIZE) / (1024.0 * 1024.0);
+}
+
+ProgressReporter::ProgressReporter(const string &format, int interval_ms)
+    : format(format), interval_ms(interval_ms), start(Clock::now()), lastCheck(start), lastReport(start)
+{
+}
+
+void ProgressReporter::check(Clock::time_point now, uint64_t expanded, uint64_t generated, size_t open, size_t closed, float f)
+{
+    double sinceCheck = chrono::duration<double, milli>(now - lastCheck).count();
+    lastCheck = now;
+    if (sinceCheck < interval_ms / 50.0 && checkMask < (1u << 20) - 1)
+        checkMask = checkMask * 2 + 1;
+    else if (sinceCheck > interval_ms / 2.0 && checkMask > 0)
+        checkMask >>= 1;
+
+    double sinceReport = chrono::duration<double>(now - lastReport).count();
+    if (sinceReport * 1000 < interval_ms)
+        return;
+
+    double expandRate = (expanded - lastExpanded) / sinceReport;
+    double generateRate = (generated - lastGenerated) / sinceReport;
+    double elapsed = chrono::duration<double>(now - start).count();
+    lastReport = now;
+    lastExpanded = expanded;
+    lastGenerated = generated;
+
+    char line[512];
+    if (format == "json") {
+        snprintf(line, sizeof(line),
+                 "{\"progress\":{\"elapsed_s\":%.2f,\"expanded\":%llu,\"expanded_per_s\":%.0f,\"generated\":%llu,"
+                 "\"generated_per_s\":%.0f,\"open\":%zu,\"closed\":%zu,\"f\":%g,\"best_h\":%g,\"rss_mb\":%.1f}}",
+                 elapsed, (unsigned long long)expanded, expandRate, (unsigned long long)generated, generateRate,
+                 open, closed, f, bestH, residentMegabytes());
+    } else {
+        snprintf(line, sizeof(line),
+                 "[%7.2fs] expanded %llu (%.0f/s), generated %llu (%.0f/s), open %zu, closed %zu, f %g, best h %g, rss %.1f MB",
+                 elapsed, (unsigned long long)expanded, expandRate, (unsigned long long)generated, generateRate,
+                 open, closed, f, bestH, residentMegabytes());
+    }
+    cerr << line << endl;
+}
+
+uint32_t getHeuristicHam(const TaskView &task, const PackedState &state)
+{
+    if (task.header->max_effect_size <= 0) {
+        throw runtime_error("max_effect_size is less than or equal to 0");
+    }
+
+    // Heuristic: number of goal conditions that are not satisfied in the given state.
+    uint32_t missing = countUnsatisfiedGoals(task, state);
+
+    // Make the h value admissable
+    uint32_t actions = (missing + task.header->max_effect_size - 1) / task.header->max_effect_size;
+    return actions * task.header->min_action_cost;
+}
+
+SearchResult astar(const TaskView &task, const SearchOptions &options, HeuristicCache *cache)
+{
+    GroundedSpace space(task, options, cache);
+    return astarSearch(space, options);
+}
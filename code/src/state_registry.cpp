@@ -0,0 +1,177 @@
+#include "planner/state_registry.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+static const size_t ARENA_BLOCK_WORDS = 1 << 15;
+
+static uint32_t ceilLog2(uint32_t n)
+{
+    uint32_t bits = 0;
+    while ((uint64_t(1) << bits) < n)
+        bits++;
+    return bits;
+}
+
+StateRegistry::StateRegistry(uint32_t words, uint32_t shards)
+    : words(max<uint32_t>(words, 1)), shardBits(min<uint32_t>(ceilLog2(shards), 16)),
+      shards(new Shard[size_t(1) << shardBits])
+{
+}
+
+uint64_t StateRegistry::hash(const uint64_t *state) const
+{
+    uint64_t x = 0;
+    for (uint32_t w = 0; w < words; w++) {
+        x = (x ^ state[w]) * 0x9e3779b97f4a7c15ull;
+        x ^= x >> 32;
+    }
+    // The shard comes from the high bits and the slot from the low ones
+    x ^= x >> 29;
+    x *= 0xbf58476d1ce4e5b9ull;
+    return x ^ (x >> 32);
+}
+
+// A copy of the state in the thread's arena
+const uint64_t *StateRegistry::store(Arena &arena, const uint64_t *state)
+{
+    size_t blockWords = max<size_t>(ARENA_BLOCK_WORDS, words);
+    if (arena.blocks.empty() || arena.used + words > blockWords) {
+        arena.blocks.emplace_back(new uint64_t[blockWords]);
+        arena.used = 0;
+    }
+    uint64_t *copy = arena.blocks.back().get() + arena.used;
+    memcpy(copy, state, words * sizeof(uint64_t));
+    arena.used += words;
+    return copy;
+}
+
+const StateRegistry::Slot *StateRegistry::findLocked(const Shard &shard, const uint64_t *state, uint32_t tag) const
+{
+    if (shard.slots.empty())
+        return nullptr;
+    size_t mask = shard.slots.size() - 1;
+    for (size_t i = tag & mask;; i = (i + 1) & mask) {
+        const Slot &slot = shard.slots[i];
+        if (!slot.state)
+            return nullptr;
+        if (slot.tag == tag && memcmp(slot.state, state, words * sizeof(uint64_t)) == 0)
+            return &slot;
+    }
+}
+
+uint32_t StateRegistry::insertLocked(uint32_t s, const uint64_t *state, uint32_t tag, Arena &arena, bool &added)
+{
+    Shard &shard = shards[s];
+    const Slot *found = findLocked(shard, state, tag);
+    if (found) {
+        added = false;
+        return found->id;
+    }
+
+    if ((shard.states.size() + 1) * 2 > shard.slots.size()) {
+        vector<Slot> old(max<size_t>(shard.slots.size() * 2, 64), Slot{nullptr, 0, 0});
+        old.swap(shard.slots);
+        size_t mask = shard.slots.size() - 1;
+        for (const Slot &slot : old) {
+            if (!slot.state)
+                continue;
+            size_t i = slot.tag & mask;
+            while (shard.slots[i].state)
+                i = (i + 1) & mask;
+            shard.slots[i] = slot;
+        }
+    }
+
+    uint64_t index = shard.states.size();
+    if (index >> (32 - shardBits))
+        throw runtime_error("State registry is full");
+    uint32_t id = (uint32_t)(index << shardBits) | s;
+    const uint64_t *copy = store(arena, state);
+    shard.states.push_back(copy);
+
+    size_t mask = shard.slots.size() - 1;
+    size_t i = tag & mask;
+    while (shard.slots[i].state)
+        i = (i + 1) & mask;
+    shard.slots[i] = Slot{copy, id, tag};
+    added = true;
+    return id;
+}
+
+StateRegistry::Writer StateRegistry::writer()
+{
+    lock_guard<mutex> guard(arenasLock);
+    arenas.emplace_back(new Arena());
+    return Writer(*this, *arenas.back());
+}
+
+StateRegistry::Writer::Writer(StateRegistry &registry, Arena &arena)
+    : registry(registry), arena(arena), pending(size_t(1) << registry.shardBits)
+{
+}
+
+uint32_t StateRegistry::Writer::insert(const PackedState &state, bool &added)
+{
+    uint64_t h = registry.hash(state.data());
+    uint32_t s = registry.shardOf(h);
+    lock_guard<mutex> guard(registry.shards[s].lock);
+    return registry.insertLocked(s, state.data(), (uint32_t)h, arena, added);
+}
+
+void StateRegistry::Writer::insert(const vector<PackedState> &states, vector<uint32_t> &ids, vector<bool> &added)
+{
+    ids.resize(states.size());
+    added.resize(states.size());
+    hashes.resize(states.size());
+    for (uint32_t i = 0; i < states.size(); i++) {
+        hashes[i] = registry.hash(states[i].data());
+        pending[registry.shardOf(hashes[i])].push_back(i);
+    }
+
+    for (uint32_t s = 0; s < pending.size(); s++) {
+        if (pending[s].empty())
+            continue;
+        {
+            lock_guard<mutex> guard(registry.shards[s].lock);
+            for (uint32_t i : pending[s]) {
+                bool isNew;
+                ids[i] = registry.insertLocked(s, states[i].data(), (uint32_t)hashes[i], arena, isNew);
+                added[i] = isNew;
+            }
+        }
+        pending[s].clear();
+    }
+}
+
+bool StateRegistry::find(const PackedState &state, uint32_t &id)
+{
+    uint64_t h = hash(state.data());
+    Shard &shard = shards[shardOf(h)];
+    lock_guard<mutex> guard(shard.lock);
+    const Slot *found = findLocked(shard, state.data(), (uint32_t)h);
+    if (found)
+        id = found->id;
+    return found != nullptr;
+}
+
+PackedState StateRegistry::state(uint32_t id)
+{
+    Shard &shard = shards[id & ((1u << shardBits) - 1)];
+    lock_guard<mutex> guard(shard.lock);
+    const uint64_t *words = shard.states.at(id >> shardBits);
+    return PackedState(words, words + this->words);
+}
+
+size_t StateRegistry::size()
+{
+    size_t count = 0;
+    for (size_t s = 0; s < (size_t(1) << shardBits); s++) {
+        lock_guard<mutex> guard(shards[s].lock);
+        count += shards[s].states.size();
+    }
+    return count;
+}
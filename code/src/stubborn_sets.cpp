@@ -0,0 +1,118 @@
+#include "planner/stubborn_sets.h"
+
+#include <algorithm>
+
+using namespace std;
+
+StubbornSets::StubbornSets(const TaskView &task)
+    : task(task), preposUsers(task.num_facts()), prenegUsers(task.num_facts()), adders(task.num_facts()),
+      deleters(task.num_facts()), interference(task.num_actions()), interferenceKnown(task.num_actions(), false),
+      inSet(task.num_actions(), 0)
+{
+    for (uint32_t a = 0; a < task.num_actions(); a++) {
+        forEachFact(task.mask(a, MASK_PRE_POS), [&](uint32_t f) { preposUsers[f].push_back(a); });
+        forEachFact(task.mask(a, MASK_PRE_NEG), [&](uint32_t f) { prenegUsers[f].push_back(a); });
+        forEachFact(task.mask(a, MASK_ADD), [&](uint32_t f) { adders[f].push_back(a); });
+        forEachFact(task.mask(a, MASK_DEL), [&](uint32_t f) { deleters[f].push_back(a); });
+    }
+}
+
+void StubbornSets::addAll(const vector<uint32_t> &actions)
+{
+    for (uint32_t a : actions) {
+        if (inSet[a] != epoch) {
+            inSet[a] = epoch;
+            stubborn.push_back(a);
+        }
+    }
+}
+
+const vector<uint32_t> &StubbornSets::interferingWith(uint32_t a)
+{
+    if (interferenceKnown[a])
+        return interference[a];
+
+    vector<uint32_t> &result = interference[a];
+    vector<bool> seen(task.num_actions(), false);
+    seen[a] = true;
+    auto collect = [&](const vector<uint32_t> &actions) {
+        for (uint32_t b : actions) {
+            if (!seen[b]) {
+                seen[b] = true;
+                result.push_back(b);
+            }
+        }
+    };
+    forEachFact(task.mask(a, MASK_DEL), [&](uint32_t f) { collect(preposUsers[f]); collect(adders[f]); });
+    forEachFact(task.mask(a, MASK_ADD), [&](uint32_t f) { collect(prenegUsers[f]); collect(deleters[f]); });
+    forEachFact(task.mask(a, MASK_PRE_POS), [&](uint32_t f) { collect(deleters[f]); });
+    forEachFact(task.mask(a, MASK_PRE_NEG), [&](uint32_t f) { collect(adders[f]); });
+
+    interferenceKnown[a] = true;
+    return result;
+}
+
+const vector<uint32_t> &StubbornSets::necessaryEnablingSet(const PackedState &state, uint32_t a) const
+{
+    const vector<uint32_t> *best = nullptr;
+    const uint64_t *pos = task.mask(a, MASK_PRE_POS);
+    const uint64_t *neg = task.mask(a, MASK_PRE_NEG);
+    for (uint32_t w = 0; w < task.state_words(); w++) {
+        uint64_t missing = pos[w] & ~state[w];
+        while (missing) {
+            uint32_t f = w * 64 + __builtin_ctzll(missing);
+            missing &= missing - 1;
+            if (!best || adders[f].size() < best->size())
+                best = &adders[f];
+        }
+        uint64_t violated = neg[w] & state[w];
+        while (violated) {
+            uint32_t f = w * 64 + __builtin_ctzll(violated);
+            violated &= violated - 1;
+            if (!best || deleters[f].size() < best->size())
+                best = &deleters[f];
+        }
+    }
+    return *best;
+}
+
+void StubbornSets::prune(const PackedState &state, vector<uint32_t> &applicable)
+{
+    applicable_total += applicable.size();
+
+    // The first unsatisfied goal: a missing fact must be added, a present negative one deleted
+    const vector<uint32_t> *achievers = nullptr;
+    for (uint32_t w = 0; w < task.state_words() && !achievers; w++) {
+        uint64_t missing = task.goal_pos[w] & ~state[w];
+        uint64_t violated = task.goal_neg[w] & state[w];
+        if (missing | violated) {
+            uint32_t f = w * 64 + __builtin_ctzll(missing | violated);
+            achievers = (missing >> (f % 64)) & 1 ? &adders[f] : &deleters[f];
+        }
+    }
+    if (!achievers || applicable.size() <= 1)
+        return;
+
+    if (++epoch == 0) {
+        fill(inSet.begin(), inSet.end(), 0);
+        epoch = 1;
+    }
+    stubborn.clear();
+    addAll(*achievers);
+
+    for (size_t i = 0; i < stubborn.size(); i++) {
+        uint32_t a = stubborn[i];
+        if (isApplicable(task, state, a))
+            addAll(interferingWith(a));
+        else
+            addAll(necessaryEnablingSet(state, a));
+    }
+
+    size_t kept = 0;
+    for (uint32_t a : applicable) {
+        if (inSet[a] == epoch)
+            applicable[kept++] = a;
+    }
+    applicable_pruned += applicable.size() - kept;
+    applicable.resize(kept);
+}
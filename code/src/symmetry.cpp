@@ -0,0 +1,340 @@
+#include "planner/symmetry.h"
+
+#include <algorithm>
+#include <list>
+#include <map>
+#include <stdexcept>
+#include <unordered_map>
+
+using namespace std;
+
+void parseAtomName(const string &name, string &predicate, vector<string> &args)
+{
+    args.clear();
+    size_t open = name.find('(');
+    predicate = name.substr(0, open);
+    if (open == string::npos)
+        return;
+    string inner = name.substr(open + 1, name.size() - open - 2);
+    for (const string &arg : parse_symbols(inner))
+        args.push_back(arg);
+}
+
+static bool transposeAtom(const string &name, const string &a, const string &b, string &image)
+{
+    string predicate;
+    vector<string> args;
+    parseAtomName(name, predicate, args);
+    bool moved = false;
+    for (string &arg : args) {
+        if (arg == a) {
+            arg = b;
+            moved = true;
+        } else if (arg == b) {
+            arg = a;
+            moved = true;
+        }
+    }
+    image = GroundedCondition(predicate, list<string>(args.begin(), args.end())).toString();
+    return moved;
+}
+
+// Colour refinement on the problem description graph; returns the stable colour of every object
+static unordered_map<string, uint32_t> refineObjectColours(const TaskView &task)
+{
+    struct AtomVertex
+    {
+        uint32_t colour;
+        vector<string> args;
+    };
+
+    vector<AtomVertex> atoms;
+    map<string, uint32_t> labelColours;
+    auto labelColour = [&](const string &label) {
+        auto it = labelColours.find(label);
+        if (it != labelColours.end())
+            return it->second;
+        uint32_t colour = labelColours.size();
+        labelColours[label] = colour;
+        return colour;
+    };
+
+    PackedState initial = task.initial_state();
+    unordered_map<string, uint32_t> objectColour;
+    auto addAtom = [&](uint32_t f, const string &role) {
+        string predicate;
+        vector<string> args;
+        parseAtomName(task.fact_name(f), predicate, args);
+        atoms.push_back(AtomVertex{labelColour(role + ":" + predicate), args});
+        for (const string &arg : args)
+            objectColour[arg] = 0;
+    };
+    for (uint32_t f = 0; f < task.num_facts(); f++) {
+        if (testFact(initial, f))
+            addAtom(f, "init");
+    }
+    for (uint32_t f = 0; f < task.num_facts(); f++) {
+        if ((task.goal_pos[f / 64] >> (f % 64)) & 1)
+            addAtom(f, "goal");
+        if ((task.goal_neg[f / 64] >> (f % 64)) & 1)
+            addAtom(f, "goalneg");
+    }
+    // Objects that only occur in action facts still take part, with no incident atoms
+    for (uint32_t f = 0; f < task.num_facts(); f++) {
+        string predicate;
+        vector<string> args;
+        parseAtomName(task.fact_name(f), predicate, args);
+        for (const string &arg : args)
+            objectColour.emplace(arg, 0);
+    }
+
+    size_t numColours = 1;
+    while (true) {
+        // New object colour: old colour plus the multiset of (atom colour, position, neighbour colours)
+        map<string, vector<string>> signatures;
+        for (const auto &entry : objectColour)
+            signatures[entry.first].push_back(to_string(entry.second));
+        for (const AtomVertex &atom : atoms) {
+            string atomSignature = to_string(atom.colour);
+            for (const string &arg : atom.args)
+                atomSignature += "," + to_string(objectColour[arg]);
+            for (size_t pos = 0; pos < atom.args.size(); pos++)
+                signatures[atom.args[pos]].push_back(atomSignature + "@" + to_string(pos));
+        }
+
+        map<string, uint32_t> signatureColours;
+        unordered_map<string, uint32_t> refined;
+        for (auto &entry : signatures) {
+            sort(entry.second.begin() + 1, entry.second.end());
+            string signature;
+            for (const string &part : entry.second)
+                signature += part + ";";
+            auto it = signatureColours.find(signature);
+            if (it == signatureColours.end())
+                it = signatureColours.emplace(signature, signatureColours.size()).first;
+            refined[entry.first] = it->second;
+        }
+
+        objectColour = refined;
+        if (signatureColours.size() == numColours)
+            break;
+        numColours = signatureColours.size();
+    }
+    return objectColour;
+}
+
+// Fact swaps of the transposition (a b), or false if it is not an automorphism of the task
+static bool verifyTransposition(const TaskView &task, const unordered_map<string, uint32_t> &factIndex,
+                                const unordered_map<string, uint32_t> &actionIndex, const string &a, const string &b,
+                                vector<pair<uint32_t, uint32_t>> &swaps, vector<uint32_t> &actionImage)
+{
+    vector<uint32_t> factImage(task.num_facts());
+    string image;
+    for (uint32_t f = 0; f < task.num_facts(); f++) {
+        factImage[f] = f;
+        if (transposeAtom(task.fact_name(f), a, b, image)) {
+            auto it = factIndex.find(image);
+            if (it == factIndex.end())
+                return false;
+            factImage[f] = it->second;
+        }
+    }
+
+    auto mapsOnto = [&](const uint64_t *from, const uint64_t *to) {
+        for (uint32_t f = 0; f < task.num_facts(); f++) {
+            bool set = (from[f / 64] >> (f % 64)) & 1;
+            uint32_t g = factImage[f];
+            if (set != (bool)((to[g / 64] >> (g % 64)) & 1))
+                return false;
+        }
+        return true;
+    };
+
+    if (!mapsOnto(task.initial, task.initial) || !mapsOnto(task.goal_pos, task.goal_pos) ||
+        !mapsOnto(task.goal_neg, task.goal_neg))
+        return false;
+
+    actionImage.assign(task.num_actions(), 0);
+    for (uint32_t act = 0; act < task.num_actions(); act++) {
+        uint32_t target = act;
+        if (transposeAtom(task.action_name(act), a, b, image)) {
+            auto it = actionIndex.find(image);
+            if (it == actionIndex.end())
+                return false;
+            target = it->second;
+        }
+        if (task.action_cost(act) != task.action_cost(target))
+            return false;
+        for (int kind = 0; kind < NUM_ACTION_MASKS; kind++) {
+            if (!mapsOnto(task.mask(act, (ActionMask)kind), task.mask(target, (ActionMask)kind)))
+                return false;
+        }
+        actionImage[act] = target;
+    }
+
+    swaps.clear();
+    for (uint32_t f = 0; f < task.num_facts(); f++) {
+        if (factImage[f] > f)
+            swaps.push_back(make_pair(f, factImage[f]));
+    }
+    return true;
+}
+
+SymmetryGroup detectSymmetries(const TaskView &task)
+{
+    SymmetryGroup group;
+
+    unordered_map<string, uint32_t> factIndex, actionIndex;
+    for (uint32_t f = 0; f < task.num_facts(); f++)
+        factIndex[task.fact_name(f)] = f;
+    for (uint32_t act = 0; act < task.num_actions(); act++)
+        actionIndex[task.action_name(act)] = act;
+
+    map<uint32_t, vector<string>> colourClasses;
+    for (const auto &entry : refineObjectColours(task))
+        colourClasses[entry.second].push_back(entry.first);
+
+    for (auto &entry : colourClasses) {
+        vector<string> &objects = entry.second;
+        sort(objects.begin(), objects.end());
+
+        // Orbits within a colour class; transpositions of objects already in one orbit add nothing new
+        vector<int> orbit(objects.size());
+        for (size_t i = 0; i < objects.size(); i++)
+            orbit[i] = i;
+        for (size_t i = 0; i < objects.size(); i++) {
+            for (size_t j = i + 1; j < objects.size(); j++) {
+                if (orbit[j] != (int)j)
+                    continue;
+                vector<pair<uint32_t, uint32_t>> swaps;
+                vector<uint32_t> actionImage;
+                if (verifyTransposition(task, factIndex, actionIndex, objects[i], objects[j], swaps, actionImage)) {
+                    group.generators.push_back(swaps);
+                    group.action_images.push_back(actionImage);
+                    orbit[j] = orbit[i];
+                }
+            }
+        }
+
+        map<int, vector<string>> orbits;
+        for (size_t i = 0; i < objects.size(); i++)
+            orbits[orbit[i]].push_back(objects[i]);
+        for (auto &o : orbits) {
+            if (o.second.size() > 1)
+                group.object_orbits.push_back(o.second);
+        }
+    }
+    return group;
+}
+
+void canonicalize(const SymmetryGroup &group, PackedState &state, vector<uint32_t> *applied)
+{
+    PackedState image;
+    bool improved = true;
+    while (improved) {
+        improved = false;
+        for (uint32_t i = 0; i < group.generators.size(); i++) {
+            const auto &swaps = group.generators[i];
+            image = state;
+            for (const auto &swap : swaps) {
+                bool first = testFact(state, swap.first);
+                bool second = testFact(state, swap.second);
+                if (first != second) {
+                    image[swap.first / 64] ^= uint64_t(1) << (swap.first % 64);
+                    image[swap.second / 64] ^= uint64_t(1) << (swap.second % 64);
+                }
+            }
+            if (image < state) {
+                state.swap(image);
+                improved = true;
+                if (applied)
+                    applied->push_back(i);
+            }
+        }
+    }
+}
+
+// Grounded space whose states are canonical orbit representatives, so that
+// symmetric states are detected as duplicates. Heuristics are symmetric, so
+// they are evaluated on the representative unchanged.
+struct SymmetricSpace
+{
+    typedef PackedState State;
+    typedef PackedStateHasher StateHasher;
+
+    GroundedSpace inner;
+    const SymmetryGroup &group;
+
+    SymmetricSpace(const TaskView &task, const SymmetryGroup &group, const SearchOptions &options)
+        : inner(task, options), group(group)
+    {
+    }
+
+    State initial_state() const
+    {
+        State state = inner.initial_state();
+        canonicalize(group, state);
+        return state;
+    }
+    bool is_goal(const State &state) const { return inner.is_goal(state); }
+    void applicable_actions(const State &state, vector<uint32_t> &actions) const { inner.applicable_actions(state, actions); }
+    void apply(const State &state, uint32_t action, State &result) const
+    {
+        inner.apply(state, action, result);
+        canonicalize(group, result);
+    }
+    uint32_t action_cost(uint32_t action) const { return inner.action_cost(action); }
+    uint32_t heuristic(const State &state) { return inner.heuristic(state); }
+};
+
+// A plan found over representatives applies each action to a representative.
+// The real state is always the image of the representative under an
+// automorphism, kept as its map on actions: the plan's action mapped by it
+// applies to the real state and leads to the image of the next representative.
+// Canonicalizing composes the map with the inverse of the generators applied;
+// each is an involution, so that is the same generators in reverse order.
+static vector<uint32_t> unfoldSymmetricPlan(const TaskView &task, const SymmetryGroup &group, const vector<uint32_t> &plan)
+{
+    vector<uint32_t> toReal(task.num_actions()), composed(task.num_actions());
+    for (uint32_t a = 0; a < task.num_actions(); a++)
+        toReal[a] = a;
+    vector<uint32_t> applied;
+    auto follow = [&](PackedState &representative) {
+        applied.clear();
+        canonicalize(group, representative, &applied);
+        for (uint32_t a = 0; a < task.num_actions(); a++) {
+            uint32_t image = a;
+            for (auto it = applied.rbegin(); it != applied.rend(); ++it)
+                image = group.action_images[*it][image];
+            composed[a] = toReal[image];
+        }
+        toReal.swap(composed);
+    };
+
+    PackedState representative = task.initial_state();
+    follow(representative);
+    PackedState state = task.initial_state();
+    PackedState next;
+    vector<uint32_t> unfolded;
+    for (uint32_t action : plan) {
+        uint32_t real = toReal[action];
+        if (!isApplicable(task, state, real))
+            throw runtime_error("Unable to unfold symmetric plan");
+        applyAction(task, state, real, next);
+        state.swap(next);
+        unfolded.push_back(real);
+
+        applyAction(task, representative, action, next);
+        representative.swap(next);
+        follow(representative);
+    }
+    return unfolded;
+}
+
+SearchResult symmetricAstar(const TaskView &task, const SymmetryGroup &group, const SearchOptions &options)
+{
+    SymmetricSpace space(task, group, options);
+    SearchResult result = astarSearch(space, options);
+    result.plan = unfoldSymmetricPlan(task, group, result.plan);
+    return result;
+}
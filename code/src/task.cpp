@@ -0,0 +1,485 @@
+#include "planner/task.h"
+#include "planner/profiling.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+static void alignTo8(string &image)
+{
+    while (image.size() % 8 != 0)
+        image.push_back('\0');
+}
+
+template <typename T>
+static uint64_t appendSection(string &image, const T *data, size_t count)
+{
+    alignTo8(image);
+    uint64_t offset = image.size();
+    image.append(reinterpret_cast<const char *>(data), count * sizeof(T));
+    return offset;
+}
+
+// The sections of a task image, in file order
+struct TaskSections
+{
+    vector<uint32_t> factNameOffsets;
+    vector<uint32_t> actionNameOffsets;
+    string strings;
+    vector<uint64_t> masks;
+    vector<uint32_t> costs;
+    vector<uint64_t> initial;
+    vector<uint32_t> goal;
+    vector<uint64_t> goalMasks;
+    vector<uint32_t> successorIndex;
+};
+
+// Lay out the image; the header is rewritten once all offsets are known
+static vector<uint64_t> layoutImage(TaskHeader header, const TaskSections &sections)
+{
+    string image(sizeof(TaskHeader), '\0');
+    header.fact_names_offset = appendSection(image, sections.factNameOffsets.data(), sections.factNameOffsets.size());
+    header.action_names_offset =
+        appendSection(image, sections.actionNameOffsets.data(), sections.actionNameOffsets.size());
+    header.strings_offset = appendSection(image, sections.strings.data(), sections.strings.size());
+    header.masks_offset = appendSection(image, sections.masks.data(), sections.masks.size());
+    header.costs_offset = appendSection(image, sections.costs.data(), sections.costs.size());
+    header.initial_offset = appendSection(image, sections.initial.data(), sections.initial.size());
+    header.goal_offset = appendSection(image, sections.goal.data(), sections.goal.size());
+    header.goal_masks_offset = appendSection(image, sections.goalMasks.data(), sections.goalMasks.size());
+    header.successor_offset = appendSection(image, sections.successorIndex.data(), sections.successorIndex.size());
+    alignTo8(image);
+    header.file_size = image.size();
+    memcpy(&image[0], &header, sizeof(header));
+
+    vector<uint64_t> buffer(image.size() / 8);
+    memcpy(buffer.data(), image.data(), image.size());
+    return buffer;
+}
+
+// Cheapest and most expensive action, for the heuristics that scale by cost
+static void setCostRange(TaskHeader &header, const vector<uint32_t> &costs)
+{
+    header.min_action_cost = costs.empty() ? 1 : *min_element(costs.begin(), costs.end());
+    header.max_action_cost = costs.empty() ? 1 : *max_element(costs.begin(), costs.end());
+}
+
+// Successor generator index. Each action is keyed on the positive precondition
+// that is changed by some action and shared by the fewest actions, so that
+// static facts (always true) do not make every bucket visited in every state.
+static vector<uint32_t> buildSuccessorIndex(uint32_t numFacts, uint32_t numActions, uint32_t words,
+                                            const vector<uint64_t> &masks)
+{
+    auto forEachFact = [words](const uint64_t *bits, auto visit) {
+        for (uint32_t w = 0; w < words; w++) {
+            for (uint64_t b = bits[w]; b; b &= b - 1)
+                visit(w * 64 + __builtin_ctzll(b));
+        }
+    };
+    vector<uint32_t> preconditionUses(numFacts, 0);
+    vector<bool> changed(numFacts, false);
+    for (size_t a = 0; a < numActions; a++) {
+        const uint64_t *actionMasks = masks.data() + a * NUM_ACTION_MASKS * words;
+        forEachFact(actionMasks + MASK_PRE_POS * words, [&](uint32_t f) { preconditionUses[f]++; });
+        forEachFact(actionMasks + MASK_ADD * words, [&](uint32_t f) { changed[f] = true; });
+        forEachFact(actionMasks + MASK_DEL * words, [&](uint32_t f) { changed[f] = true; });
+    }
+
+    vector<vector<uint32_t>> buckets(numFacts + 1);
+    for (size_t a = 0; a < numActions; a++) {
+        uint32_t key = numFacts;
+        forEachFact(masks.data() + (a * NUM_ACTION_MASKS + MASK_PRE_POS) * words, [&](uint32_t f) {
+            if (!changed[f])
+                return;
+            if (key == numFacts || preconditionUses[f] < preconditionUses[key] ||
+                (preconditionUses[f] == preconditionUses[key] && f < key))
+                key = f;
+        });
+        buckets[key].push_back(a);
+    }
+    vector<uint32_t> successorIndex;
+    uint32_t start = 0;
+    for (const auto &bucket : buckets) {
+        successorIndex.push_back(start);
+        start += bucket.size();
+    }
+    successorIndex.push_back(start);
+    for (const auto &bucket : buckets)
+        successorIndex.insert(successorIndex.end(), bucket.begin(), bucket.end());
+    return successorIndex;
+}
+
+vector<uint64_t> compileTask(const Env &env, const vector<GroundedAction> &allActions)
+{
+    PROFILE_SCOPE("compile");
+    // Fact table: every fact in the initial state, goal or a grounded action, sorted by name
+    set<string> factNames;
+    for (const auto &gc : env.get_initial_conditions())
+        factNames.insert(gc.toString());
+    for (const auto &gc : env.get_goal_conditions())
+        factNames.insert(gc.toString());
+    for (const auto &action : allActions) {
+        for (const auto &pc : action.get_grounded_preconditions())
+            factNames.insert(pc.toString());
+        for (const auto &ef : action.get_grounded_effects())
+            factNames.insert(ef.toString());
+    }
+
+    unordered_map<string, uint32_t> factIds;
+    vector<string> facts(factNames.begin(), factNames.end());
+    for (uint32_t f = 0; f < facts.size(); f++)
+        factIds[facts[f]] = f;
+
+    TaskHeader header;
+    memset(&header, 0, sizeof(header));
+    strncpy(header.magic, TASK_MAGIC, sizeof(header.magic));
+    header.version = TASK_FORMAT_VERSION;
+    header.num_facts = facts.size();
+    header.num_actions = allActions.size();
+    header.state_words = (facts.size() + 63) / 64;
+    if (header.state_words == 0)
+        header.state_words = 1;
+    // The largest effect scales the goal-count heuristic down to an admissible estimate
+    for (const auto &action : allActions)
+        header.max_effect_size = max<uint32_t>(header.max_effect_size, action.get_grounded_effects().size());
+    vector<uint32_t> costs;
+    for (const auto &action : allActions)
+        costs.push_back(action.get_cost());
+    setCostRange(header, costs);
+
+    const uint32_t words = header.state_words;
+    auto setBit = [](uint64_t *bits, uint32_t f) { bits[f / 64] |= uint64_t(1) << (f % 64); };
+
+    // Names
+    string strings;
+    vector<uint32_t> factNameOffsets, actionNameOffsets;
+    for (const string &name : facts) {
+        factNameOffsets.push_back(strings.size());
+        strings += name;
+    }
+    factNameOffsets.push_back(strings.size());
+    for (const auto &action : allActions) {
+        actionNameOffsets.push_back(strings.size());
+        strings += action.toString();
+    }
+    actionNameOffsets.push_back(strings.size());
+
+    // Action masks
+    vector<uint64_t> masks((size_t)allActions.size() * NUM_ACTION_MASKS * words, 0);
+    for (size_t a = 0; a < allActions.size(); a++) {
+        uint64_t *actionMasks = masks.data() + a * NUM_ACTION_MASKS * words;
+        for (const auto &pc : allActions[a].get_grounded_preconditions()) {
+            uint32_t f = factIds[pc.toString()];
+            setBit(actionMasks + (pc.get_truth() ? MASK_PRE_POS : MASK_PRE_NEG) * words, f);
+        }
+        for (const auto &ef : allActions[a].get_grounded_effects()) {
+            uint32_t f = factIds[ef.toString()];
+            setBit(actionMasks + (ef.get_truth() ? MASK_ADD : MASK_DEL) * words, f);
+        }
+    }
+
+    // Initial state and goal
+    vector<uint64_t> initial(words, 0);
+    for (const auto &gc : env.get_initial_conditions())
+        setBit(initial.data(), factIds[gc.toString()]);
+    vector<uint32_t> goal;
+    vector<uint64_t> goalMasks(2 * words, 0);
+    for (const auto &gc : env.get_goal_conditions()) {
+        uint32_t f = factIds[gc.toString()];
+        if (gc.get_truth())
+            goal.push_back(f);
+        setBit(goalMasks.data() + (gc.get_truth() ? 0 : words), f);
+    }
+    sort(goal.begin(), goal.end());
+    header.num_goals = goal.size();
+
+    vector<uint32_t> successorIndex = buildSuccessorIndex(facts.size(), allActions.size(), words, masks);
+
+    return layoutImage(header, {factNameOffsets, actionNameOffsets, strings, masks, costs, initial, goal,
+                                goalMasks, successorIndex});
+}
+
+vector<uint64_t> restrictTask(const TaskView &task, const vector<bool> &keepAction)
+{
+    const uint32_t words = task.state_words();
+    TaskHeader header = *task.header;
+    TaskSections sections;
+    sections.factNameOffsets.assign(task.fact_name_offsets, task.fact_name_offsets + task.num_facts() + 1);
+    sections.strings.assign(task.strings, task.fact_name_offsets[task.num_facts()]);
+    sections.initial.assign(task.initial, task.initial + words);
+    sections.goal.assign(task.goal, task.goal + header.num_goals);
+    sections.goalMasks.assign(task.goal_pos, task.goal_pos + 2 * words);
+
+    header.num_actions = 0;
+    header.max_effect_size = 0;
+    for (uint32_t a = 0; a < task.num_actions(); a++) {
+        if (!keepAction[a])
+            continue;
+        header.num_actions++;
+        sections.actionNameOffsets.push_back(sections.strings.size());
+        sections.strings += task.action_name(a);
+        const uint64_t *actionMasks = task.mask(a, MASK_PRE_POS);
+        sections.masks.insert(sections.masks.end(), actionMasks, actionMasks + NUM_ACTION_MASKS * words);
+        sections.costs.push_back(task.action_cost(a));
+
+        uint32_t effects = 0;
+        for (uint32_t w = 0; w < words; w++)
+            effects += __builtin_popcountll(task.mask(a, MASK_ADD)[w]) + __builtin_popcountll(task.mask(a, MASK_DEL)[w]);
+        header.max_effect_size = max(header.max_effect_size, effects);
+    }
+    // Keeps the goal-count heuristic defined when no action is left
+    header.max_effect_size = max(header.max_effect_size, 1u);
+    setCostRange(header, sections.costs);
+    sections.actionNameOffsets.push_back(sections.strings.size());
+    sections.successorIndex = buildSuccessorIndex(task.num_facts(), header.num_actions, words, sections.masks);
+    return layoutImage(header, sections);
+}
+
+bool bindTaskView(const void *data, size_t size, TaskView &view, string &error)
+{
+    const char *base = static_cast<const char *>(data);
+    if (size < sizeof(TaskHeader)) {
+        error = "file too small for a task header";
+        return false;
+    }
+    const TaskHeader *header = reinterpret_cast<const TaskHeader *>(base);
+    if (strncmp(header->magic, TASK_MAGIC, sizeof(header->magic)) != 0) {
+        error = "not a compiled task (bad magic)";
+        return false;
+    }
+    if (header->version != TASK_FORMAT_VERSION) {
+        error = "unsupported task format version " + to_string(header->version) +
+                " (expected " + to_string(TASK_FORMAT_VERSION) + ")";
+        return false;
+    }
+    if (header->file_size != size) {
+        error = "truncated task file";
+        return false;
+    }
+    if (header->state_words != max<uint64_t>((uint64_t(header->num_facts) + 63) / 64, 1)) {
+        error = "state words do not match the fact count";
+        return false;
+    }
+
+    // Every section has to lie in the file, at the length its header counts give
+    auto fits = [&](uint64_t offset, uint64_t count, uint64_t elementSize) {
+        return offset % 8 == 0 && offset <= size && count <= (size - offset) / elementSize;
+    };
+    const uint64_t words = header->state_words;
+    if (!fits(header->fact_names_offset, uint64_t(header->num_facts) + 1, sizeof(uint32_t)) ||
+        !fits(header->action_names_offset, uint64_t(header->num_actions) + 1, sizeof(uint32_t)) ||
+        !fits(header->strings_offset, 0, 1) ||
+        !fits(header->masks_offset, header->num_actions, NUM_ACTION_MASKS * words * sizeof(uint64_t)) ||
+        !fits(header->costs_offset, header->num_actions, sizeof(uint32_t)) ||
+        !fits(header->initial_offset, words, sizeof(uint64_t)) ||
+        !fits(header->goal_offset, header->num_goals, sizeof(uint32_t)) ||
+        !fits(header->goal_masks_offset, 2 * words, sizeof(uint64_t)) ||
+        !fits(header->successor_offset, uint64_t(header->num_facts) + 2, sizeof(uint32_t))) {
+        error = "task section out of bounds";
+        return false;
+    }
+
+    // Names are ordered and end inside the file, and goals name facts
+    auto offsetsValid = [&](uint64_t section, uint32_t count) {
+        const uint32_t *offsets = reinterpret_cast<const uint32_t *>(base + section);
+        for (uint32_t i = 0; i < count; i++) {
+            if (offsets[i] > offsets[i + 1])
+                return false;
+        }
+        return offsets[count] <= size - header->strings_offset;
+    };
+    if (!offsetsValid(header->fact_names_offset, header->num_facts) ||
+        !offsetsValid(header->action_names_offset, header->num_actions)) {
+        error = "name out of bounds";
+        return false;
+    }
+    const uint32_t *goal = reinterpret_cast<const uint32_t *>(base + header->goal_offset);
+    for (uint32_t i = 0; i < header->num_goals; i++) {
+        if (goal[i] >= header->num_facts) {
+            error = "goal fact out of range";
+            return false;
+        }
+    }
+
+    const uint32_t *costs = reinterpret_cast<const uint32_t *>(base + header->costs_offset);
+    for (uint32_t a = 0; a < header->num_actions; a++) {
+        if (costs[a] > MAX_ACTION_COST) {
+            error = "action cost out of range";
+            return false;
+        }
+    }
+
+    // Bits past the last fact would be read as facts that do not exist
+    uint64_t padding = header->num_facts % 64 ? ~uint64_t(0) << (header->num_facts % 64) : 0;
+    if (header->num_facts == 0)
+        padding = ~uint64_t(0);
+    auto padded = [&](uint64_t section, uint64_t count) {
+        const uint64_t *bits = reinterpret_cast<const uint64_t *>(base + section);
+        for (uint64_t i = 0; i < count; i++) {
+            if (bits[i * words + words - 1] & padding)
+                return false;
+        }
+        return true;
+    };
+    if (!padded(header->masks_offset, uint64_t(header->num_actions) * NUM_ACTION_MASKS) ||
+        !padded(header->initial_offset, 1) || !padded(header->goal_masks_offset, 2)) {
+        error = "fact out of range";
+        return false;
+    }
+
+    // The successor index has ordered bucket starts ending at most at the
+    // action count, and lists valid actions that lie in the file
+    const uint32_t *starts = reinterpret_cast<const uint32_t *>(base + header->successor_offset);
+    const uint64_t actionsOffset = header->successor_offset + (uint64_t(header->num_facts) + 2) * sizeof(uint32_t);
+    for (uint32_t b = 0; b <= header->num_facts; b++) {
+        if (starts[b] > starts[b + 1]) {
+            error = "successor index out of order";
+            return false;
+        }
+    }
+    uint32_t listed = starts[header->num_facts + 1];
+    if (listed > header->num_actions || listed > (size - actionsOffset) / sizeof(uint32_t)) {
+        error = "successor index out of bounds";
+        return false;
+    }
+    const uint32_t *successorActions = starts + header->num_facts + 2;
+    for (uint32_t i = 0; i < listed; i++) {
+        if (successorActions[i] >= header->num_actions) {
+            error = "successor index out of bounds";
+            return false;
+        }
+    }
+
+    view.header = header;
+    view.fact_name_offsets = reinterpret_cast<const uint32_t *>(base + header->fact_names_offset);
+    view.action_name_offsets = reinterpret_cast<const uint32_t *>(base + header->action_names_offset);
+    view.strings = base + header->strings_offset;
+    view.masks = reinterpret_cast<const uint64_t *>(base + header->masks_offset);
+    view.costs = reinterpret_cast<const uint32_t *>(base + header->costs_offset);
+    view.initial = reinterpret_cast<const uint64_t *>(base + header->initial_offset);
+    view.goal = reinterpret_cast<const uint32_t *>(base + header->goal_offset);
+    view.goal_pos = reinterpret_cast<const uint64_t *>(base + header->goal_masks_offset);
+    view.goal_neg = view.goal_pos + header->state_words;
+    view.successor_starts = reinterpret_cast<const uint32_t *>(base + header->successor_offset);
+    view.successor_actions = view.successor_starts + header->num_facts + 2;
+    return true;
+}
+
+bool writeTaskFile(const string &path, const vector<uint64_t> &image)
+{
+    ofstream out(path, ios::binary | ios::trunc);
+    if (!out.is_open())
+        return false;
+    out.write(reinterpret_cast<const char *>(image.data()), image.size() * sizeof(uint64_t));
+    return out.good();
+}
+
+MappedTask::MappedTask() : data(MAP_FAILED) {}
+
+bool MappedTask::open(const string &path, string &error)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "unable to open " + path;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        error = "unable to stat " + path;
+        ::close(fd);
+        return false;
+    }
+    size = st.st_size;
+    data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        error = "unable to map " + path;
+        return false;
+    }
+    return bindTaskView(data, size, view, error);
+}
+
+MappedTask::~MappedTask()
+{
+    if (data != MAP_FAILED)
+        munmap(data, size);
+}
+
+template <typename Applicable>
+void collectApplicableActions(const TaskView &task, const PackedState &state, vector<uint32_t> &validActions, Applicable applicable)
+{
+    PROFILE_SCOPE("applicable_actions");
+    validActions.clear();
+
+    // Only the buckets of facts that hold in the state can contain applicable actions
+    for (uint32_t w = 0; w < task.state_words(); w++) {
+        uint64_t bits = state[w];
+        while (bits) {
+            uint32_t f = w * 64 + __builtin_ctzll(bits);
+            bits &= bits - 1;
+            for (const uint32_t *a = task.bucket_begin(f); a != task.bucket_end(f); a++) {
+                if (applicable(task, state, *a))
+                    validActions.push_back(*a);
+            }
+        }
+    }
+
+    const uint32_t always = task.num_facts();
+    for (const uint32_t *a = task.bucket_begin(always); a != task.bucket_end(always); a++) {
+        if (applicable(task, state, *a))
+            validActions.push_back(*a);
+    }
+}
+
+void getApplicableActions(const TaskView &task, const PackedState &state, vector<uint32_t> &validActions)
+{
+    collectApplicableActions(task, state, validActions, isApplicable);
+}
+
+void getApplicableActionsEDL(const TaskView &task, const PackedState &state, vector<uint32_t> &validActions)
+{
+    collectApplicableActions(task, state, validActions, isApplicableEDL);
+}
+
+unordered_map<string, uint32_t> buildFactIndex(const TaskView &task)
+{
+    unordered_map<string, uint32_t> factIndex;
+    for (uint32_t f = 0; f < task.num_facts(); f++)
+        factIndex[task.fact_name(f)] = f;
+    return factIndex;
+}
+
+TaskInstance::TaskInstance(const TaskView &domain, const unordered_map<string, uint32_t> &factIndex,
+                           const set<string> &initialFacts, const set<string> &goalFacts)
+    : header(*domain.header), initial(domain.state_words(), 0), goal_masks(2 * domain.state_words(), 0), view(domain)
+{
+    // Facts outside the domain's fact table are not used by any action
+    for (const string &fact : initialFacts) {
+        auto it = factIndex.find(fact);
+        if (it != factIndex.end())
+            initial[it->second / 64] |= uint64_t(1) << (it->second % 64);
+    }
+    // so a goal outside it can only hold if it holds initially
+    for (const string &fact : goalFacts) {
+        auto it = factIndex.find(fact);
+        if (it != factIndex.end()) {
+            goal.push_back(it->second);
+            goal_masks[it->second / 64] |= uint64_t(1) << (it->second % 64);
+        } else if (initialFacts.count(fact) == 0)
+            unreachable_goal = true;
+    }
+    sort(goal.begin(), goal.end());
+
+    header.num_goals = goal.size();
+    view.header = &header;
+    view.initial = initial.data();
+    view.goal = goal.data();
+    view.goal_pos = goal_masks.data();
+    view.goal_neg = goal_masks.data() + domain.state_words();
+}
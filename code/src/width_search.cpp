@@ -0,0 +1,259 @@
+#include "planner/width_search.h"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <unordered_set>
+
+using namespace std;
+
+typedef SearchNode<PackedState> WidthNode;
+
+NoveltyTable::NoveltyTable(uint32_t num_facts, uint32_t width) : width(width), factBits((num_facts + 63) / 64, 0)
+{
+    if (width < 1 || width > 2)
+        throw runtime_error("Novelty tables support width 1 and 2");
+}
+
+// True if the pair was not in the set; the table doubles at half load
+bool NoveltyTable::insertPair(uint64_t key)
+{
+    if ((pairCount + 1) * 2 > pairs.size()) {
+        vector<uint64_t> old(max<size_t>(pairs.size() * 2, 1024), 0);
+        old.swap(pairs);
+        shift = 64 - __builtin_ctzll(pairs.size());
+        pairCount = 0;
+        for (uint64_t k : old) {
+            if (k)
+                insertPair(k);
+        }
+    }
+    size_t mask = pairs.size() - 1;
+    for (size_t slot = (key * 0x9e3779b97f4a7c15ull) >> shift;; slot = (slot + 1) & mask) {
+        if (pairs[slot] == key)
+            return false;
+        if (pairs[slot] == 0) {
+            pairs[slot] = key;
+            pairCount++;
+            return true;
+        }
+    }
+}
+
+uint32_t NoveltyTable::update(const vector<uint32_t> &facts, const vector<uint32_t> &fresh)
+{
+    uint32_t novelty = width + 1;
+    for (uint32_t f : fresh) {
+        uint64_t bit = 1ull << (f % 64);
+        if (!(factBits[f / 64] & bit)) {
+            factBits[f / 64] |= bit;
+            novelty = 1;
+        }
+    }
+    if (width < 2)
+        return novelty;
+
+    for (uint32_t f : fresh) {
+        for (uint32_t other : facts) {
+            if (other == f)
+                continue;
+            uint64_t key = ((uint64_t)min(f, other) + 1) << 32 | max(f, other);
+            if (insertPair(key) && novelty > 2)
+                novelty = 2;
+        }
+    }
+    return novelty;
+}
+
+static void stateFacts(const TaskView &task, const PackedState &state, vector<uint32_t> &facts)
+{
+    facts.clear();
+    for (uint32_t w = 0; w < task.state_words(); w++) {
+        for (uint64_t bits = state[w]; bits; bits &= bits - 1)
+            facts.push_back(w * 64 + __builtin_ctzll(bits));
+    }
+}
+
+// Facts of state that do not hold in parent
+static void addedFacts(const TaskView &task, const PackedState &parent, const PackedState &state, vector<uint32_t> &facts)
+{
+    facts.clear();
+    for (uint32_t w = 0; w < task.state_words(); w++) {
+        for (uint64_t bits = state[w] & ~parent[w]; bits; bits &= bits - 1)
+            facts.push_back(w * 64 + __builtin_ctzll(bits));
+    }
+}
+
+static void extractPlan(const WidthNode *goal, WidthSearchResult &result)
+{
+    for (const WidthNode *node = goal; node->parent != nullptr; node = node->parent)
+        result.plan.push_back(node->action);
+    reverse(result.plan.begin(), result.plan.end());
+    result.status = SEARCH_SOLVED;
+    result.cost = goal->g;
+}
+
+// One IW(k) run; false if it ended without a plan, either exhausted or stopped by the guard
+static bool iteratedWidth(const TaskView &task, uint32_t k, SearchGuard &guard, ProgressReporter *progress,
+                          WidthSearchResult &result)
+{
+    NoveltyTable table(task.num_facts(), k);
+    vector<uint32_t> facts, fresh, applicable;
+    PackedState neighbor;
+
+    // Nodes are appended in breadth-first order, so the node list is the queue
+    vector<unique_ptr<WidthNode>> nodes;
+    nodes.emplace_back(new WidthNode{task.initial_state(), 0, 0, 0, nullptr, -1});
+    stateFacts(task, nodes[0]->state, facts);
+    table.update(facts, facts);
+
+    for (size_t next = 0; next < nodes.size(); next++) {
+        if (guard.exceeded(result.states_expanded, result.status))
+            return false;
+
+        WidthNode *current = nodes[next].get();
+        result.states_expanded++;
+        PROFILE_COUNT("expansions", 1);
+        if (progress)
+            progress->tick(result.states_expanded, result.states_generated, nodes.size() - next - 1, next, current->g, 0);
+
+        getApplicableActions(task, current->state, applicable);
+        for (uint32_t action : applicable) {
+            applyAction(task, current->state, action, neighbor);
+            result.states_generated++;
+            PROFILE_COUNT("generated", 1);
+
+            uint32_t g = current->g + task.action_cost(action);
+            if (isGoal(task, neighbor)) {
+                WidthNode goal{neighbor, g, 0, g, current, (int32_t)action};
+                extractPlan(&goal, result);
+                result.width = k;
+                return true;
+            }
+
+            // A state that adds no fact has no new tuple either
+            addedFacts(task, current->state, neighbor, fresh);
+            if (!fresh.empty()) {
+                stateFacts(task, neighbor, facts);
+                if (table.update(facts, fresh) <= k) {
+                    nodes.emplace_back(new WidthNode{neighbor, g, 0, g, current, (int32_t)action});
+                    continue;
+                }
+            }
+            PROFILE_COUNT("novelty_pruned", 1);
+        }
+    }
+    result.status = SEARCH_UNSOLVABLE;
+    return false;
+}
+
+static void bestFirstWidth(const TaskView &task, SearchGuard &guard, ProgressReporter *progress, WidthSearchResult &result)
+{
+    uint32_t numGoals = 0;
+    for (uint32_t w = 0; w < task.state_words(); w++)
+        numGoals += __builtin_popcountll(task.goal_pos[w]) + __builtin_popcountll(task.goal_neg[w]);
+
+    // One novelty table per number of unsatisfied goals, made on first use
+    vector<unique_ptr<NoveltyTable>> tables(numGoals + 1);
+    auto novelty = [&](uint32_t goals, const vector<uint32_t> &facts, const vector<uint32_t> &fresh) {
+        if (!tables[goals])
+            tables[goals].reset(new NoveltyTable(task.num_facts(), 2));
+        return tables[goals]->update(facts, fresh);
+    };
+
+    // f is the novelty and h the number of unsatisfied goals, so the open list
+    // orders by novelty, then goals, then age
+    BucketOpenList<WidthNode> openList(TIE_LOWEST_H_FIFO);
+    unordered_set<PackedState, PackedStateHasher> seen;
+    vector<unique_ptr<WidthNode>> nodes;
+    vector<uint32_t> facts, fresh, applicable;
+    PackedState neighbor;
+
+    nodes.emplace_back(new WidthNode{task.initial_state(), 0, countUnsatisfiedGoals(task, task.initial_state()), 0, nullptr, -1});
+    WidthNode *root = nodes.back().get();
+    stateFacts(task, root->state, facts);
+    root->f = novelty(root->h, facts, facts);
+    openList.push(root);
+    seen.insert(root->state);
+
+    while (!openList.empty()) {
+        if (guard.exceeded(result.states_expanded, result.status))
+            return;
+
+        WidthNode *current = openList.top();
+        openList.pop();
+        result.states_expanded++;
+        PROFILE_COUNT("expansions", 1);
+        PROFILE_HISTOGRAM("novelty", current->f);
+        if (progress)
+            progress->tick(result.states_expanded, result.states_generated, openList.size(), seen.size() - openList.size(),
+                           current->f, current->h);
+
+        getApplicableActions(task, current->state, applicable);
+        for (uint32_t action : applicable) {
+            applyAction(task, current->state, action, neighbor);
+            result.states_generated++;
+            PROFILE_COUNT("generated", 1);
+            if (!seen.insert(neighbor).second)
+                continue;
+
+            uint32_t g = current->g + task.action_cost(action);
+            nodes.emplace_back(new WidthNode{neighbor, g, countUnsatisfiedGoals(task, neighbor), 0, current, (int32_t)action});
+            WidthNode *node = nodes.back().get();
+            if (node->h == 0 && isGoal(task, neighbor)) {
+                extractPlan(node, result);
+                return;
+            }
+
+            // Within the parent's table only the added facts can form new tuples
+            stateFacts(task, neighbor, facts);
+            if (node->h == current->h)
+                addedFacts(task, current->state, neighbor, fresh);
+            else
+                fresh = facts;
+            node->f = novelty(node->h, facts, fresh);
+            openList.push(node);
+        }
+    }
+
+    result.status = SEARCH_UNSOLVABLE;
+    result.f_bound = numeric_limits<float>::infinity();
+}
+
+WidthSearchResult iteratedWidthSearch(const TaskView &task, const SearchOptions &options, uint32_t max_width)
+{
+    WidthSearchResult result;
+    if (isGoal(task, task.initial_state())) {
+        result.status = SEARCH_SOLVED;
+        return result;
+    }
+
+    unique_ptr<ProgressReporter> progress;
+    if (options.progress_format != "off")
+        progress.reset(new ProgressReporter(options.progress_format, options.progress_interval_ms));
+    SearchGuard guard(options);
+
+    for (uint32_t k = 1; k <= max_width; k++) {
+        if (iteratedWidth(task, k, guard, progress.get(), result) || result.status != SEARCH_UNSOLVABLE)
+            return result;
+    }
+    bestFirstWidth(task, guard, progress.get(), result);
+    return result;
+}
+
+WidthSearchResult bestFirstWidthSearch(const TaskView &task, const SearchOptions &options)
+{
+    WidthSearchResult result;
+    if (isGoal(task, task.initial_state())) {
+        result.status = SEARCH_SOLVED;
+        return result;
+    }
+
+    unique_ptr<ProgressReporter> progress;
+    if (options.progress_format != "off")
+        progress.reset(new ProgressReporter(options.progress_format, options.progress_interval_ms));
+    SearchGuard guard(options);
+
+    bestFirstWidth(task, guard, progress.get(), result);
+    return result;
+}